@@ -0,0 +1,42 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <optional>
+
+#include "cube_state.h"
+#include "cubie_cube.h"
+
+
+struct BidirectionalSolverConfig {
+    int maxDepth = 14;                                  // quarter turns
+    std::size_t memoryLimit = std::size_t(2) << 30;     // bytes for both frontiers and visited sets
+    unsigned int threads = 0;                           // 0 = hardware concurrency
+};
+
+struct BidirectionalSolverStats {
+    std::uint64_t statesVisited = 0;
+    std::size_t peakMemory = 0;
+    bool memoryLimitHit = false;
+};
+
+// Optimal quarter turn solver for short scrambles: breadth first search from the
+// scrambled and the solved state at the same time, always growing the smaller
+// frontier, until the two visited sets meet. States are stored as CubieKey in
+// open addressing hash sets together with the move that reached them.
+class BidirectionalSolver {
+public:
+    explicit BidirectionalSolver(BidirectionalSolverConfig config = {});
+
+    // Shortest solution, std::nullopt if the state is unsolvable, the solution is longer than
+    // maxDepth or the memory limit is reached
+    auto solve(const CubeState& state) -> std::optional<std::vector<Move>>;
+    auto solve(const CubieCube& cube) -> std::optional<std::vector<Move>>;
+
+    auto stats() const -> const BidirectionalSolverStats& { return m_stats; }
+
+private:
+    BidirectionalSolverConfig m_config;
+    BidirectionalSolverStats m_stats;
+};
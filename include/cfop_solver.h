@@ -0,0 +1,54 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <string>
+#include <memory>
+#include <cstdint>
+#include <unordered_map>
+
+#include "cube_state.h"
+#include "cubie_cube.h"
+
+
+// Human style solver: cross on D, four F2L pairs, then one look OLL and PLL.
+// Cross and pair search use small BFS distance tables, the last layer cases are
+// found by hashing the last layer sticker pattern into a precomputed algorithm table.
+// Building the tables takes a moment; solve() is const and safe to call from many threads.
+class CfopSolver {
+public:
+    CfopSolver();
+    ~CfopSolver();
+
+    // Throws std::runtime_error if the state cannot be solved
+    auto solve(const CubeState& state) const -> std::vector<SolveStage>;
+    auto solve(const CubieCube& cube) const -> std::vector<SolveStage>;
+
+    // number of distinct last layer patterns in the tables
+    auto ollCaseCount() const -> std::size_t { return m_oll.size(); }
+    auto pllCaseCount() const -> std::size_t { return m_pll.size(); }
+
+    static auto ollKey(const CubeState& state) -> std::uint32_t;
+    static auto pllKey(const CubeState& state) -> std::uint64_t;
+
+private:
+    static constexpr int maxPairDepth = 14;
+
+    // BFS distances for a set of pieces (slot and orientation of each), defined in cfop_solver.cpp
+    struct PieceTable;
+    struct PieceLocations;
+
+    auto pairBound(const PieceLocations& loc, int pair) const -> int;
+
+    auto solveCross(CubieCube& cube) const -> std::vector<Move>;
+    auto solvePair(const CubieCube& cube, int pair, int bound, unsigned int solvedPairs, std::vector<Move>& moves) const -> bool;
+
+    auto buildLastLayerTables() -> void;
+
+private:
+    std::unique_ptr<PieceTable> m_crossTable;
+    std::vector<std::vector<PieceTable>> m_pairTables; // [pair] -> pair with each two of the cross edges
+
+    std::unordered_map<std::uint32_t, std::vector<Move>> m_oll;
+    std::unordered_map<std::uint64_t, std::vector<Move>> m_pll;
+};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <span>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "cube_state.h"
+#include "cubie_cube.h"
+
+
+// Structure of arrays batch for applying the same moves to many independent cubes.
+// Every corner and edge slot is a column with one byte per cube holding the piece in
+// the low bits and its orientation above it (corners: piece | twist << 3, edges:
+// piece | flip << 4). A quarter turn only rewrites the columns of its 4 corner and
+// 4 edge slots, 32 cubes per instruction when compiled with AVX2 (-mavx2).
+class CubeBatch {
+public:
+    // cubes per vector, columns are padded to a multiple of it with solved cubes
+    static constexpr std::size_t laneCount = 32;
+
+    explicit CubeBatch(std::size_t size = 0);
+
+    auto size() const -> std::size_t { return m_size; }
+
+    // New cubes start solved
+    auto resize(std::size_t size) -> void;
+
+    auto set(std::size_t index, const CubieCube& cube) -> void;
+    auto get(std::size_t index) const -> CubieCube;
+
+    auto isSolved(std::size_t index) const -> bool;
+
+    auto applyMove(Move move) -> void;
+
+    // Applies the whole sequence to one cache sized slice of the batch before moving on
+    auto applyMoves(std::span<const Move> moves) -> void;
+
+    // true if the AVX2 kernel was compiled in, otherwise the scalar fallback is used
+    static auto vectorized() -> bool;
+
+private:
+    static constexpr int columnCount = cornerCount + edgeCount;
+
+    auto column(int c) -> std::uint8_t* { return m_data.data() + c * m_stride; }
+    auto column(int c) const -> const std::uint8_t* { return m_data.data() + c * m_stride; }
+
+    auto applyMoves(std::span<const Move> moves, std::size_t begin, std::size_t end) -> void;
+
+    std::vector<std::uint8_t> m_data;
+    std::size_t m_size;
+    std::size_t m_stride; // bytes per column
+};
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include <glm/glm.hpp>
+
+
+// One cubie: a black body with bevelled edges and corners and an octagonal sticker
+// set into each of its 6 faces. The body around a sticker is a ring, so no fragment is
+// shaded twice. Vertices are 8 bytes: position as normalized shorts and the face id
+// (0..5 sticker of that colorMask face, bodyFaceId for the body). Every polygon is flat,
+// so the fragment shader derives the normal and vertices are shared between polygons.
+// Triangles are ordered so that their last (provoking) vertex carries the face id.
+struct CubieVertex {
+    std::int16_t position[3];
+    std::uint16_t faceId;
+};
+
+static_assert(sizeof(CubieVertex) == 8);
+
+constexpr std::uint16_t bodyFaceId = 6;
+
+struct CubieMeshData {
+    std::vector<CubieVertex> vertices;
+    std::vector<std::uint16_t> indices;
+};
+
+// Sizes relative to a cubie of edge length 1
+struct CubieMeshConfig {
+    float bevel = 0.07f;            // width of the chamfer on edges and corners
+    float stickerMargin = 0.025f;   // gap between the sticker and the chamfer
+    float stickerCorner = 0.07f;    // cut off the sticker corners
+};
+
+auto buildCubieMesh(const CubieMeshConfig& config = {}) -> CubieMeshData;
+
+// Per cubie data, uploaded once per frame
+struct CubieInstance {
+    glm::mat4 model;
+    std::uint32_t colorMask;
+};
+
+// GPU copy of the cubie mesh, all cubies are drawn with one instanced draw call,
+// so the cost per cubie is a 68 byte instance record. Requires a current GL context.
+class CubeMesh {
+public:
+    explicit CubeMesh(const CubieMeshConfig& config = {});
+
+    auto draw(const std::vector<CubieInstance>& instances) -> void;
+    auto destroy() -> void;
+
+    auto vertexCount() const -> std::size_t { return m_vertexCount; }
+    auto indexCount() const -> std::size_t { return m_indexCount; }
+
+private:
+    unsigned int m_vao;
+    unsigned int m_vertexBuffer;
+    unsigned int m_indexBuffer;
+    unsigned int m_instanceBuffer;
+    std::size_t m_vertexCount;
+    std::size_t m_indexCount;
+    std::size_t m_instanceCapacity;
+};
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <optional>
+
+#include <glm/glm.hpp>
+
+#include "cube_state.h"
+
+
+// Mouse picking on the cube grid. The cube is treated as the box around all
+// cubies (half size cubeSpacing + 0.5), so a pick is one ray/box slab test and
+// a rounding to the grid, independent of the cubie count and without reading
+// anything back from the GPU. Layers keep their grid slots while turning, so
+// picks stay valid during an animation.
+
+struct Ray {
+    glm::vec3 origin;
+    glm::vec3 direction;
+};
+
+struct FaceletHit {
+    int cell[3];        // grid position of the cubie, each in [-1, 1]
+    int normalAxis;     // 0 = x, 1 = y, 2 = z
+    int normalSign;     // +1 or -1
+    glm::vec3 point;    // world position of the hit on the cube surface
+};
+
+// World space ray through the cursor, x and y in window coordinates (origin top left)
+auto cursorRay(double x, double y, int width, int height, const glm::mat4& projection, const glm::mat4& view) -> Ray;
+
+auto pickFacelet(const Ray& ray, float cubeSpacing) -> std::optional<FaceletHit>;
+
+// Turn produced by dragging the grabbed facelet to where ray meets its face plane.
+// std::nullopt while the drag is shorter than threshold (world units) or when it
+// would turn the middle slice, which has no Move.
+auto dragTurn(const FaceletHit& grab, const Ray& ray, float cubeSpacing, float threshold) -> std::optional<MoveAxis>;
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+
+// one byte per sticker, a CubeState is 54 bytes
+enum class Color : std::uint8_t { BLUE, GREEN, ORANGE, RED, YELLOW, WHITE, BLACK };
+
+struct CubeState {
+    Color front[3][3];
+    Color back[3][3];
+    Color left[3][3];
+    Color right[3][3];
+    Color top[3][3];
+    Color bottom[3][3];
+};
+
+// Facelets are addressed as face * 9 + row * 3 + col, faces in CubeState member order
+constexpr int faceletCount = 54;
+
+auto colorToString(Color c) -> std::string;
+
+// Outer layer quarter turns, same conventions as the key bindings (direction -1 is the plain turn)
+enum class Move : std::uint8_t {
+    FRONT, FRONT_INV,
+    BACK, BACK_INV,
+    LEFT, LEFT_INV,
+    RIGHT, RIGHT_INV,
+    UP, UP_INV,
+    DOWN, DOWN_INV
+};
+
+constexpr int moveCount = 12;
+
+// axis: 0 = x, 1 = y, 2 = z
+struct MoveAxis {
+    int axis;
+    int side;
+    int direction;
+};
+
+auto moveToAxis(Move move) -> MoveAxis;
+auto moveFromAxis(int axis, int side, int direction) -> Move;
+auto inverseMove(Move move) -> Move;
+auto moveToString(Move move) -> std::string;
+
+// Standard notation, e.g. "R U R' U2"; half turns expand to two quarter turns.
+// Throws std::runtime_error on unknown tokens.
+auto movesFromString(const std::string& notation) -> std::vector<Move>;
+auto movesToString(const std::vector<Move>& moves) -> std::string;
+
+// Labeled part of a solution, e.g. "cross" or "oll"
+struct SolveStage {
+    std::string label;
+    std::vector<Move> moves;
+};
+
+auto solvedCubeState() -> CubeState;
+
+// Facelet on the grid position (x, y, z) in [-1, 1] facing along +/- normalAxis
+auto faceletIndex(int x, int y, int z, int normalAxis, int normalSign) -> int;
+auto faceletColor(const CubeState& state, int index) -> Color;
+
+// Permutes the facelets of state by a single quarter turn
+auto applyMove(CubeState& state, Move move) -> void;
+
+auto isSolved(const CubeState& state) -> bool;
+
+auto operator==(const CubeState& a, const CubeState& b) -> bool;
+
+// 54 color letters (B G O R Y W, X for black) in facelet order
+auto stateToString(const CubeState& state) -> std::string;
+
+// Inverse of stateToString(), throws std::runtime_error on a wrong length or letter
+auto stateFromString(const std::string& text) -> CubeState;
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "cube_state.h"
+
+
+constexpr int cornerCount = 8;
+constexpr int edgeCount = 12;
+
+// Piece level view of the cube. Slots and pieces use the same numbering:
+// corners URF, UFL, ULB, UBR, DFR, DLF, DBL, DRB
+// edges UR, UF, UL, UB, DR, DF, DL, DB, FR, FL, BL, BR
+// cornerPerm[slot] is the piece sitting in slot, cornerOrient[slot] its twist (0..2).
+// Orientation is measured against the U/D facelet (F/B for middle layer edges).
+struct CubieCube {
+    std::array<std::uint8_t, cornerCount> cornerPerm;
+    std::array<std::uint8_t, cornerCount> cornerOrient;
+    std::array<std::uint8_t, edgeCount> edgePerm;
+    std::array<std::uint8_t, edgeCount> edgeOrient;
+
+    auto operator==(const CubieCube& other) const -> bool = default;
+};
+
+auto solvedCubieCube() -> CubieCube;
+
+// Throws std::runtime_error if the stickers do not describe valid pieces or show one twice
+auto cubieFromState(const CubeState& state) -> CubieCube;
+auto stateFromCubie(const CubieCube& cube) -> CubeState;
+
+auto applyMove(CubieCube& cube, Move move) -> void;
+
+// Reachable by turns: every piece appears exactly once with an orientation in range, twists
+// sum to 0 mod 3, flips are even and both permutations have the same parity
+auto isSolvable(const CubieCube& cube) -> bool;
+
+// The cube a single move produces from solved, i.e. its slot permutation and orientation change
+auto moveCubie(Move move) -> const CubieCube&;
+
+// Coordinates of single aspects of a cube, used as table indices
+constexpr int cornerOrientCoordCount = 2187; // 3^7, last twist follows from the others
+constexpr int edgeOrientCoordCount = 2048;   // 2^11
+constexpr int cornerPermCoordCount = 40320;  // 8!
+constexpr int edgePermCoordCount = 479001600; // 12!
+
+auto cornerOrientCoord(const CubieCube& cube) -> int;
+auto edgeOrientCoord(const CubieCube& cube) -> int;
+auto cornerPermCoord(const CubieCube& cube) -> int;
+auto edgePermCoord(const CubieCube& cube) -> int;
+
+auto setCornerOrientCoord(CubieCube& cube, int coord) -> void;
+auto setEdgeOrientCoord(CubieCube& cube, int coord) -> void;
+auto setCornerPermCoord(CubieCube& cube, int coord) -> void;
+auto setEdgePermCoord(CubieCube& cube, int coord) -> void;
+
+// Exact encoding of a cube: corners = cornerPerm * 3^7 + cornerOrient (27 bits),
+// edges = edgePerm * 2^11 + edgeOrient (40 bits)
+struct CubieKey {
+    std::uint64_t corners;
+    std::uint64_t edges;
+
+    auto operator==(const CubieKey& other) const -> bool = default;
+};
+
+auto cubieKey(const CubieCube& cube) -> CubieKey;
+auto cubieFromKey(const CubieKey& key) -> CubieCube;
+
+// The 67 bits of a CubieKey packed little endian into 9 bytes (corners in the low 27 bits)
+using PackedState = std::array<std::uint8_t, 9>;
+
+auto packState(const CubieCube& cube) -> PackedState;
+auto unpackState(const PackedState& packed) -> CubieCube;
+
+// Facelet indices of a slot, U/D (or F/B) reference facelet first, corners in clockwise order
+auto cornerFacelets(int slot) -> const std::array<int, 3>&;
+auto edgeFacelets(int slot) -> const std::array<int, 2>&;
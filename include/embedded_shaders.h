@@ -0,0 +1,65 @@
+#pragma once
+
+// Generated by tools/embed_shaders.cpp from the files in shader/, do not edit.
+
+#include <string_view>
+
+
+// rubiks_cube.vert
+constexpr std::string_view rubiksCubeVert = R"glsl(#version 460 core
+layout (location = 0) in vec3 aPos;         // normalized shorts
+layout (location = 1) in uint aFaceId;      // 0..5 sticker of that colorMask face, 6 body
+
+// per cubie
+layout (location = 3) in mat4 aModel;
+layout (location = 7) in uint aColorMask;
+
+out vec3 WorldPos;
+flat out uint ColorIndex;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+void main()
+{
+    vec4 worldPos = aModel * vec4(aPos, 1.0);
+    gl_Position = projection * view * worldPos;
+    WorldPos = worldPos.xyz;
+
+    // stickers on internal faces take the body color, they only show between turning layers
+    ColorIndex = (aFaceId < 6u && (aColorMask & (1u << aFaceId)) != 0u) ? aFaceId : 6u;
+}
+)glsl";
+
+// rubiks_cube.frag
+constexpr std::string_view rubiksCubeFrag = R"glsl(#version 460 core
+out vec4 FragColor;
+
+in vec3 WorldPos;
+flat in uint ColorIndex;
+
+// indexed by the colorMask bit of the face, 6 is the cubie body
+const vec3 palette[7] = vec3[](
+    vec3(0.0, 0.0, 1.0),    // Blue (Back)
+    vec3(0.0, 1.0, 0.0),    // Green (Front)
+    vec3(1.0, 0.5, 0.0),    // Orange (Left)
+    vec3(1.0, 0.0, 0.0),    // Red (Right)
+    vec3(1.0, 1.0, 0.0),    // Yellow (Bottom)
+    vec3(1.0, 1.0, 1.0),    // White (Top)
+    vec3(0.03, 0.03, 0.03)  // Black (Body)
+);
+
+const vec3 lightDirection = normalize(vec3(0.4, 0.8, 0.6));
+
+void main()
+{
+    // every polygon is flat, so its normal follows from the screen space derivatives;
+    // back faces are culled, so it always points out of the cubie
+    vec3 normal = normalize(cross(dFdx(WorldPos), dFdy(WorldPos)));
+
+    // mostly ambient so the sticker colors stay flat, enough diffuse to show the bevels
+    float light = 0.6 + 0.4 * max(dot(normal, lightDirection), 0.0);
+    FragColor = vec4(palette[ColorIndex] * light, 1.0);
+}
+)glsl";
+
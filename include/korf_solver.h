@@ -0,0 +1,65 @@
+#pragma once
+
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <functional>
+#include <filesystem>
+
+#include "cube_state.h"
+#include "cubie_cube.h"
+#include "pattern_database.h"
+
+
+struct KorfSolverConfig {
+    int maxDepth = 26;                                  // quarter turns, 26 solves every position
+    unsigned int threads = 0;                           // 0 = hardware concurrency
+    std::filesystem::path databaseDirectory;            // pattern databases are cached here, empty = generate every time
+    std::chrono::milliseconds progressInterval{ 1000 };
+};
+
+struct KorfSolverStats {
+    std::uint64_t nodes = 0;    // heuristic evaluations over all iterations
+    int bound = 0;              // current iteration bound
+    double seconds = 0.0;
+
+    auto nodesPerSecond() const -> double { return seconds > 0.0 ? static_cast<double>(nodes) / seconds : 0.0; }
+};
+
+// Called on the solving thread every progressInterval and after every iteration
+using KorfProgressCallback = std::function<void(const KorfSolverStats& stats)>;
+
+// Optimal quarter turn solver for any position: IDA* with the max of a corner and two
+// 6 edge pattern databases as heuristic (~86 MB at 4 bits per entry), raised to the
+// parity every quarter turn flips. Each iteration enumerates the subtrees below the
+// first few moves and lets the worker threads take them from a shared queue; the
+// bound of the next iteration is the smallest f any worker cut off.
+class KorfSolver {
+public:
+    // Loads the pattern databases or generates them, which takes minutes
+    explicit KorfSolver(KorfSolverConfig config = {});
+
+    // Shortest solution, std::nullopt if it is longer than maxDepth or the state is unsolvable
+    auto solve(const CubeState& state) -> std::optional<std::vector<Move>>;
+    auto solve(const CubieCube& cube) -> std::optional<std::vector<Move>>;
+
+    auto setProgressCallback(KorfProgressCallback callback) -> void { m_progress = std::move(callback); }
+
+    // Admissible distance estimate, exact 0 only for solved
+    auto heuristic(const PieceCube& cube, int parity) const -> int;
+
+    auto stats() const -> const KorfSolverStats& { return m_stats; }
+
+    // databases that were not found in databaseDirectory
+    auto generatedDatabases() const -> int { return m_generatedDatabases; }
+
+private:
+    KorfSolverConfig m_config;
+    KorfSolverStats m_stats;
+    KorfProgressCallback m_progress;
+    PatternDatabase m_corners;
+    PatternDatabase m_edgesLow;
+    PatternDatabase m_edgesHigh;
+    int m_generatedDatabases;
+};
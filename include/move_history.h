@@ -0,0 +1,45 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <optional>
+
+#include "cube_state.h"
+
+
+// Compact log of completed turns (one byte per move) with an undo/redo cursor.
+// Every m_checkpointInterval moves a full CubeState is stored, so any position
+// can be restored by copying the nearest checkpoint and replaying < interval moves.
+class MoveHistory {
+public:
+    explicit MoveHistory(std::size_t checkpointInterval = 1024, const CubeState& initial = solvedCubeState());
+
+    // Appends a move at the cursor, dropping any redo tail
+    auto record(Move move) -> void;
+
+    // Step the cursor, returning the move that has to be applied to the cube
+    auto undo() -> std::optional<Move>;
+    auto redo() -> std::optional<Move>;
+
+    auto canUndo() const -> bool { return m_cursor > 0; }
+    auto canRedo() const -> bool { return m_cursor < m_moves.size(); }
+
+    auto cursor() const -> std::size_t { return m_cursor; }
+    auto size() const -> std::size_t { return m_moves.size(); }
+    auto moves() const -> const std::vector<Move>& { return m_moves; }
+    auto checkpointInterval() const -> std::size_t { return m_checkpointInterval; }
+
+    // State after the first `position` moves
+    auto stateAt(std::size_t position) const -> CubeState;
+
+    // Moves the cursor to position (clamped to size()) and returns the state there
+    auto seek(std::size_t position) -> CubeState;
+
+    auto clear(const CubeState& initial = solvedCubeState()) -> void;
+
+private:
+    std::size_t m_checkpointInterval;
+    std::vector<Move> m_moves;
+    std::vector<CubeState> m_checkpoints; // m_checkpoints[i] is the state after i * m_checkpointInterval moves
+    std::size_t m_cursor;
+};
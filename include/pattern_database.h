@@ -0,0 +1,76 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <filesystem>
+
+#include "cube_state.h"
+#include "cubie_cube.h"
+
+
+// Cube as seen from the pieces: corners[piece] = slot * 3 + twist,
+// edges[piece] = slot * 2 + flip. A move is one table lookup per piece and
+// the pattern database indices are ranked directly from it.
+struct PieceCube {
+    std::array<std::uint8_t, cornerCount> corners;
+    std::array<std::uint8_t, edgeCount> edges;
+
+    auto operator==(const PieceCube& other) const -> bool = default;
+};
+
+auto pieceCubeFromCubie(const CubieCube& cube) -> PieceCube;
+auto cubieFromPieceCube(const PieceCube& cube) -> CubieCube;
+
+auto applyMove(PieceCube& cube, Move move) -> void;
+
+// Parity of the corner permutation, flipped by every quarter turn
+auto cornerParity(const PieceCube& cube) -> int;
+
+enum class PatternKind : std::uint8_t {
+    CORNERS,        // all 8 corners, 8! * 3^7 entries
+    EDGES_LOW,      // edges UR..DF (pieces 0..5), 12!/6! * 2^6 entries
+    EDGES_HIGH      // edges DL..BR (pieces 6..11)
+};
+
+// Exact quarter turn distance to solved of one group of pieces, 4 bits per entry.
+// Built by a breadth first search over the whole index space; the search switches
+// from expanding the current level to checking unvisited entries against it once
+// most entries are visited.
+class PatternDatabase {
+public:
+    static constexpr int unknownDistance = 15;
+
+    explicit PatternDatabase(PatternKind kind);
+
+    static auto entryCount(PatternKind kind) -> std::size_t;
+    static auto index(PatternKind kind, const PieceCube& cube) -> std::size_t;
+
+    // threads = 0 uses hardware concurrency
+    auto generate(unsigned int threads = 0) -> void;
+
+    // false if the file is missing, does not hold a table of this kind, fails its checksum
+    // or does not look like a finished search (unknown entries, distance 0 off solved)
+    auto load(const std::filesystem::path& path) -> bool;
+    auto save(const std::filesystem::path& path) const -> bool;
+
+    auto distance(std::size_t index) const -> int {
+        return (m_table[index >> 1] >> ((index & 1) * 4)) & 0xf;
+    }
+    auto distance(const PieceCube& cube) const -> int { return distance(index(m_kind, cube)); }
+
+    auto kind() const -> PatternKind { return m_kind; }
+    auto size() const -> std::size_t { return m_size; }
+    auto memory() const -> std::size_t { return m_table.size(); }
+
+    // entries per distance, for reports
+    auto histogram() const -> std::array<std::uint64_t, 16>;
+
+private:
+    PatternKind m_kind;
+    std::size_t m_size;
+    std::vector<std::uint8_t> m_table;
+};
+
+auto patternKindName(PatternKind kind) -> const char*;
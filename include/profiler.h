@@ -0,0 +1,91 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <chrono>
+#include <filesystem>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define CUBE_PROFILER_RDTSC 1
+#elif defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#define CUBE_PROFILER_RDTSC 1
+#endif
+
+
+// Scoped zone profiler. Build with -DCUBE_PROFILING to enable it; otherwise the
+// PROFILE_* macros expand to nothing, zones cost nothing and profiler.cpp does not
+// have to be linked. Calls outside the macros belong under if constexpr (profilingEnabled).
+//
+//   auto worker() -> void {
+//       PROFILE_THREAD_NAME("worker");
+//       ...
+//   }
+//
+//   auto update() -> void {
+//       PROFILE_FUNCTION();
+//       { PROFILE_SCOPE("physics"); ... }
+//   }
+//
+// Every thread writes finished zones into its own ring buffer (the newest
+// eventsPerThread are kept), so recording takes no locks. writeChromeTrace()
+// exports them as trace event JSON for chrome://tracing or ui.perfetto.dev.
+
+#ifdef CUBE_PROFILING
+constexpr bool profilingEnabled = true;
+#else
+constexpr bool profilingEnabled = false;
+#endif
+
+class Profiler {
+public:
+    static constexpr std::size_t eventsPerThread = std::size_t(1) << 16;
+
+    // Raw timestamp, TSC ticks where available, steady_clock nanoseconds otherwise
+    static auto now() -> std::uint64_t {
+#ifdef CUBE_PROFILER_RDTSC
+        return __rdtsc();
+#else
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+    }
+
+    // name must outlive the profiler, string literals or __func__
+    static auto record(const char* name, std::uint64_t start, std::uint64_t end) -> void;
+
+    // Shown for the calling thread in the trace viewer, creates its ring buffer
+    static auto setThreadName(const std::string& name) -> void;
+
+    // Writes all buffered zones of all threads, safe to call while other threads record
+    static auto writeChromeTrace(const std::filesystem::path& path) -> bool;
+
+    // Drops the zones recorded so far
+    static auto clear() -> void;
+};
+
+class ProfileZone {
+public:
+    explicit ProfileZone(const char* name) : m_name{ name }, m_start{ Profiler::now() } {}
+    ~ProfileZone() { Profiler::record(m_name, m_start, Profiler::now()); }
+
+    ProfileZone(const ProfileZone&) = delete;
+    auto operator=(const ProfileZone&) -> ProfileZone& = delete;
+
+private:
+    const char* m_name;
+    std::uint64_t m_start;
+};
+
+#ifdef CUBE_PROFILING
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) ProfileZone PROFILE_CONCAT(profileZone, __LINE__){ name }
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__func__)
+#define PROFILE_THREAD_NAME(name) Profiler::setThreadName(name)
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_FUNCTION() ((void)0)
+#define PROFILE_THREAD_NAME(name) ((void)0)
+#endif
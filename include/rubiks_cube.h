@@ -3,6 +3,8 @@
 #include <vector>
 #include <string>
 #include <deque>
+#include <iostream>
+#include <stdexcept>
 
 #include <glad/glad.h> 
 #include <GLFW/glfw3.h>
@@ -13,7 +15,12 @@
 
 #include "stb_image.h"
 
-#include "shader.h"
+#include "cube_mesh.h"
+#include "cube_state.h"
+#include "cubie_cube.h"
+#include "move_history.h"
+#include "session_trace.h"
+#include "profiler.h"
 
 
 struct Cube {
@@ -21,45 +28,28 @@ struct Cube {
     int colorMask;
 };
 
-enum class Color { BLUE, GREEN, ORANGE, RED, YELLOW, WHITE, BLACK };
-
-struct CubeState {
-    Color front[3][3];
-    Color back[3][3];
-    Color left[3][3];
-    Color right[3][3];
-    Color top[3][3];
-    Color bottom[3][3];
-};
-
-static std::string colorToString(Color c) {
-    switch (c) {
-    case Color::BLUE: return "B";
-    case Color::GREEN: return "G";
-    case Color::ORANGE: return "O";
-    case Color::RED: return "R";
-    case Color::YELLOW: return "Y";
-    case Color::WHITE: return "W";
-    case Color::BLACK: return "X";
-    default: return "?";
-    }
-}
-
 class RubiksCube {
 public:
     struct RotationConfig {
         glm::vec3 axis;
         int side;
         int direction;
+        bool record = true; // false for undo/redo turns, which must not enter the history
+        float pause = 0.0f; // > 0: hold still for pause seconds instead of turning
+        float speed = 0.0f; // degrees per second, 0: the rotationSpeed of the cube
     };
 
+    // shuffles and solutions play back faster than turns made by hand
+    static constexpr float queuedRotationSpeed = 400.0f;
+
 public:
-    RubiksCube(float rotationSpeed, float cubeSpacing, int shuffleSteps) :
+    RubiksCube(float rotationSpeed, float cubeSpacing, int shuffleSteps, std::size_t historyCheckpointInterval = 1024) :
         m_rotationSpeed{ rotationSpeed },
         m_cubeSpacing{ cubeSpacing },
         m_shuffleSteps{ shuffleSteps },
         m_cubes{},
-        m_moveQueue{}
+        m_moveQueue{},
+        m_history{ historyCheckpointInterval }
     {
     }
 
@@ -91,11 +81,13 @@ public:
         m_rotationAxis = cfg.axis;
         m_rotationSide = cfg.side;
         m_rotationDirection = cfg.direction;
+        m_recordRotation = cfg.record;
+        m_currentSpeed = (cfg.speed > 0.0f) ? cfg.speed : m_rotationSpeed;
         m_currentAngle = 0.0f;
     }
 
     auto addMove(const glm::vec3& axis, int side, int direction) -> void {
-        m_moveQueue.push_back(
+        addMove(
             RotationConfig{
                 .axis = axis,
                 .side = side,
@@ -105,14 +97,34 @@ public:
     }
 
     auto addMove(const RotationConfig& cfg) -> void {
+        if (m_trace) {
+            if (cfg.pause > 0.0f) m_trace->addPause(cfg.pause);
+            else m_trace->addTurn(toMove(cfg), cfg.record, cfg.speed);
+        }
+
         m_moveQueue.push_back(cfg);
     }
 
+    // Queue all stages of a solution, holding for stagePause seconds after each stage
+    auto addSolution(const std::vector<SolveStage>& stages, float stagePause) -> void {
+        for (const auto& stage : stages) {
+            if (stage.moves.empty()) continue;
+
+            for (auto move : stage.moves) {
+                auto cfg = toRotationConfig(move);
+                cfg.speed = queuedRotationSpeed;
+                addMove(cfg);
+            }
+            if (stagePause > 0.0f) addMove(RotationConfig{ .axis = glm::vec3(0.0f), .side = 0, .direction = 0, .pause = stagePause });
+        }
+    }
+
     auto shuffle() -> void {
         // Shuffle cube randomly m_shuffleSteps times
         for (int i = 0; i < m_shuffleSteps; ++i) {
             // generate random rotation config values
             auto cfg = RotationConfig{};
+            cfg.speed = queuedRotationSpeed;
 
             // axis
             auto randAxis = rand() % 3;
@@ -132,22 +144,38 @@ public:
     }
 
     auto update(float deltaTime) -> void {
+        PROFILE_SCOPE("RubiksCube::update");
+
+        if (m_trace) m_trace->addFrame(deltaTime);
+
+        if (m_pauseRemaining > 0.0f) {
+            m_pauseRemaining -= deltaTime;
+
+            // a session can also come to rest at the end of a stage pause
+            if (m_trace && m_pauseRemaining <= 0.0f && m_moveQueue.empty()) m_trace->addCheck(m_state);
+            return;
+        }
+
         if (!m_isAnimating && !m_moveQueue.empty()) {
             auto queuedRotation = m_moveQueue.front();
             m_moveQueue.pop_front();
+
+            if (queuedRotation.pause > 0.0f) {
+                m_pauseRemaining = queuedRotation.pause;
+                return;
+            }
+
             m_rotationAxis = queuedRotation.axis;
             m_rotationDirection = queuedRotation.direction;
             m_rotationSide = queuedRotation.side;
+            m_recordRotation = queuedRotation.record;
+            m_currentSpeed = (queuedRotation.speed > 0.0f) ? queuedRotation.speed : m_rotationSpeed;
             m_isAnimating = true;
             m_currentAngle = 0.0f;
-            m_rotationSpeed = 400.0f;
-        }
-        else if (!m_isAnimating && m_moveQueue.empty()) {
-            m_rotationSpeed = 200.0f;
         }
 
         if (m_isAnimating) {
-            m_currentAngle += m_rotationSpeed * deltaTime;
+            m_currentAngle += m_currentSpeed * deltaTime;
 
             // check if rotation complete
             if (m_currentAngle >= m_targetAngle) {
@@ -168,6 +196,14 @@ public:
                     }
                 }
 
+                // keep the facelet view in sync with the finished turn
+                auto move = moveFromAxis(axisIndex(m_rotationAxis), m_rotationSide, m_rotationDirection);
+                applyMove(m_state, move);
+                if (m_recordRotation) m_history.record(move);
+
+                // golden state for replays whenever the cube comes to rest
+                if (m_trace && m_moveQueue.empty()) m_trace->addCheck(m_state);
+
                 //fixCubes();
                 m_isAnimating = false;
                 m_currentAngle = 0.0f;
@@ -175,7 +211,10 @@ public:
         }
     }
 
-    auto draw(Shader& shader) -> void {
+    auto draw(CubeMesh& mesh) -> void {
+        PROFILE_SCOPE("RubiksCube::draw");
+
+        m_instances.clear();
         for (auto& cube : m_cubes) {
             auto model = cube.model;
 
@@ -192,15 +231,145 @@ public:
                 }
             }
 
-            shader.setMat4("model", model);
-            shader.setInt("colorMask", cube.colorMask);
-            glDrawArrays(GL_TRIANGLES, 0, 36);
+            m_instances.push_back(CubieInstance{ model, static_cast<std::uint32_t>(cube.colorMask) });
         }
+
+        mesh.draw(m_instances);
     }
 
     auto isAnimating() const -> bool { return m_isAnimating; };
 
-    auto getCubeState() const -> CubeState {
+    // animating, pausing between solution stages or moves still queued
+    auto isBusy() const -> bool { return m_isAnimating || m_pauseRemaining > 0.0f || !m_moveQueue.empty(); }
+
+    auto history() const -> const MoveHistory& { return m_history; }
+
+    auto cubes() const -> const std::vector<Cube>& { return m_cubes; }
+
+    // Records all input from now on into trace (frames, queued turns and pauses, state jumps), nullptr stops
+    auto setTrace(SessionTrace* trace) -> void { m_trace = trace; }
+
+    // Queue the inverse of the last recorded move, ignored while busy
+    auto undo() -> bool {
+        if (isBusy()) return false;
+
+        auto move = m_history.undo();
+        if (!move) return false;
+
+        auto cfg = toRotationConfig(*move);
+        cfg.record = false;
+        addMove(cfg);
+        return true;
+    }
+
+    auto redo() -> bool {
+        if (isBusy()) return false;
+
+        auto move = m_history.redo();
+        if (!move) return false;
+
+        auto cfg = toRotationConfig(*move);
+        cfg.record = false;
+        addMove(cfg);
+        return true;
+    }
+
+    // Jump without animation to the state after `position` recorded moves
+    auto seekHistory(std::size_t position) -> bool {
+        if (isBusy()) return false;
+
+        setCubeState(m_history.seek(position));
+        return true;
+    }
+
+    // Rebuilds the cubie model matrices so that they show the given facelet state
+    auto setCubeState(const CubeState& state) -> void {
+        PROFILE_SCOPE("RubiksCube::setCubeState");
+
+        // reading the pieces throws on duplicated pieces, isSolvable rejects twisted corners,
+        // flipped edges and odd swaps, the round trip rejects moved centers
+        auto cubie = cubieFromState(state);
+        if (!isSolvable(cubie) || !(stateFromCubie(cubie) == state)) {
+            throw std::runtime_error("cube state is not reachable!");
+        }
+
+        // cubies are identified by their colorMask, bit i is the color localColors()[i]
+        Cube* cubeByMask[64] = {};
+        for (auto& cube : m_cubes) cubeByMask[cube.colorMask] = &cube;
+
+        for (int x = -1; x <= 1; ++x) {
+            for (int y = -1; y <= 1; ++y) {
+                for (int z = -1; z <= 1; ++z) {
+                    int coords[3] = { x, y, z };
+
+                    int mask = 0;
+                    int faces = 0;
+                    glm::vec3 homeNormals[3];
+                    glm::vec3 currentNormals[3];
+
+                    for (int axis = 0; axis < 3; ++axis) {
+                        if (coords[axis] == 0) continue;
+
+                        auto color = faceletColor(state, faceletIndex(x, y, z, axis, coords[axis]));
+                        auto colorIndex = static_cast<int>(color);
+                        if (color == Color::BLACK || (mask & (1 << colorIndex))) {
+                            throw std::runtime_error("cube state is not reachable!");
+                        }
+
+                        mask |= (1 << colorIndex);
+                        homeNormals[faces] = localNormals()[colorIndex];
+                        currentNormals[faces] = glm::vec3(0.0f);
+                        currentNormals[faces][axis] = float(coords[axis]);
+                        ++faces;
+                    }
+
+                    auto cube = cubeByMask[mask];
+                    if (!cube) throw std::runtime_error("cube state is not reachable!");
+
+                    // centers never leave their place and the core has no stickers
+                    auto rotation = glm::mat3(1.0f);
+                    if (faces >= 2) {
+                        auto home = glm::mat3(homeNormals[0], homeNormals[1], glm::cross(homeNormals[0], homeNormals[1]));
+                        auto current = glm::mat3(currentNormals[0], currentNormals[1], glm::cross(currentNormals[0], currentNormals[1]));
+                        rotation = current * glm::transpose(home);
+                    }
+
+                    auto pos = glm::vec3(x * m_cubeSpacing, y * m_cubeSpacing, z * m_cubeSpacing);
+                    cube->model = glm::translate(glm::mat4(1.0f), pos) * glm::mat4(rotation);
+                }
+            }
+        }
+
+        m_state = state;
+        if (m_trace) m_trace->addState(state);
+    }
+
+    // Facelet state after the last completed turn, maintained incrementally in update()
+    auto getCubeState() const -> const CubeState& { return m_state; }
+
+    auto isSolved() const -> bool { return ::isSolved(m_state); }
+
+    static auto axisIndex(const glm::vec3& axis) -> int {
+        if (std::abs(axis.x) > 0.5f) return 0;
+        if (std::abs(axis.y) > 0.5f) return 1;
+        return 2;
+    }
+
+    static auto toMove(const RotationConfig& cfg) -> Move {
+        return moveFromAxis(axisIndex(cfg.axis), cfg.side, cfg.direction);
+    }
+
+    static auto toRotationConfig(Move move) -> RotationConfig {
+        auto m = moveToAxis(move);
+        auto axis = glm::vec3(0.0f);
+        axis[m.axis] = 1.0f;
+        return RotationConfig{ .axis = axis, .side = m.side, .direction = m.direction };
+    }
+
+    // Rebuilds the facelet state from the cubie model matrices, used to validate m_state
+    auto recomputeCubeState() const -> CubeState {
+        PROFILE_SCOPE("RubiksCube::recomputeCubeState");
+
         CubeState state;
 
         // Init black
@@ -215,20 +384,8 @@ public:
             }
         }
 
-        // face normals
-        glm::vec3 localNormals[6] = {
-            glm::vec3(0.0, 0.0, -1.0),  // back
-            glm::vec3(0.0, 0.0, 1.0),   // front
-            glm::vec3(-1.0, 0.0, 0.0),  // left
-            glm::vec3(1.0, 0.0, 0.0),   // right
-            glm::vec3(0.0, -1.0, 0.0),  // bottom
-            glm::vec3(0.0, 1.0, 0.0),   // top
-        };
-
-        // colors
-        Color localColors[6] = {
-            Color::BLUE, Color::GREEN, Color::ORANGE, Color::RED, Color::YELLOW, Color::WHITE
-        };
+        const auto& normals = localNormals();
+        const auto& colors = localColors();
 
         for (auto& cube : m_cubes) {
             int x = (int)round(cube.model[3][0] / m_cubeSpacing);
@@ -240,43 +397,43 @@ public:
             for (int i = 0; i < 6; ++i) {
                 if ((cube.colorMask & (1 << i)) == 0) continue;
 
-                auto currentNormal = rotation * localNormals[i];
+                auto currentNormal = rotation * normals[i];
 
                 // Global Front (Z+)
                 if (glm::dot(currentNormal, glm::vec3(0, 0, 1)) > 0.9f) {
                     int col = x + 1;
                     int row = 1 - y;
-                    state.front[row][col] = localColors[i];
+                    state.front[row][col] = colors[i];
                 }
                 // Global Back (Z-)
                 else if (glm::dot(currentNormal, glm::vec3(0, 0, -1)) > 0.9f) {
                     int col = 1 - x;
                     int row = 1 - y;
-                    state.back[row][col] = localColors[i];
+                    state.back[row][col] = colors[i];
                 }
                 // Global Right (X+)
                 else if (glm::dot(currentNormal, glm::vec3(1, 0, 0)) > 0.9f) {
                     int col = 1 - z;
                     int row = 1 - y;
-                    state.right[row][col] = localColors[i];
+                    state.right[row][col] = colors[i];
                 }
                 // Global Left (X-)
                 else if (glm::dot(currentNormal, glm::vec3(-1, 0, 0)) > 0.9f) {
                     int col = z + 1;
                     int row = 1 - y;
-                    state.left[row][col] = localColors[i];
+                    state.left[row][col] = colors[i];
                 }
                 // Global Top (Y+)
                 else if (glm::dot(currentNormal, glm::vec3(0, 1, 0)) > 0.9f) {
                     int col = x + 1;
                     int row = z + 1; // z=-1 is top row visually? No, usually z=-1 is back.
-                    state.top[row][col] = localColors[i];
+                    state.top[row][col] = colors[i];
                 }
                 // Global Bottom (Y-)
                 else if (glm::dot(currentNormal, glm::vec3(0, -1, 0)) > 0.9f) {
                     int col = x + 1;
                     int row = 1 - z; // z=1 is top row visually
-                    state.bottom[row][col] = localColors[i];
+                    state.bottom[row][col] = colors[i];
                 }
             }
         }
@@ -302,18 +459,48 @@ public:
         std::cout << "      " << colorToString(s.bottom[2][0]) << colorToString(s.bottom[2][1]) << colorToString(s.bottom[2][2]) << "\n";
     };
 
+private:
+    // face normals, same order as the colorMask bits
+    static auto localNormals() -> const glm::vec3(&)[6] {
+        static const glm::vec3 normals[6] = {
+            glm::vec3(0.0, 0.0, -1.0),  // back
+            glm::vec3(0.0, 0.0, 1.0),   // front
+            glm::vec3(-1.0, 0.0, 0.0),  // left
+            glm::vec3(1.0, 0.0, 0.0),   // right
+            glm::vec3(0.0, -1.0, 0.0),  // bottom
+            glm::vec3(0.0, 1.0, 0.0),   // top
+        };
+        return normals;
+    }
+
+    // colors, Color enum values match the colorMask bits
+    static auto localColors() -> const Color(&)[6] {
+        static const Color colors[6] = {
+            Color::BLUE, Color::GREEN, Color::ORANGE, Color::RED, Color::YELLOW, Color::WHITE
+        };
+        return colors;
+    }
+
 private:
     float m_rotationSpeed;
     float m_cubeSpacing;
     int m_shuffleSteps;
     std::vector<Cube> m_cubes;
+    std::vector<CubieInstance> m_instances;
 
     std::deque<RotationConfig> m_moveQueue;
 
+    CubeState m_state = solvedCubeState();
+    MoveHistory m_history;
+    SessionTrace* m_trace = nullptr;
+
     bool m_isAnimating = false;
+    float m_pauseRemaining = 0.0f;
     float m_currentAngle = 0.0f;
+    float m_currentSpeed = 0.0f;
     float m_targetAngle = 90.0f;
     glm::vec3 m_rotationAxis = glm::vec3(0.0f);
     int m_rotationSide = 0;
     int m_rotationDirection = 0;
+    bool m_recordRotation = true;
 };
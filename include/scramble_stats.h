@@ -0,0 +1,76 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <string>
+#include <iosfwd>
+#include <cstdint>
+#include <random>
+#include <functional>
+
+#include "cube_state.h"
+#include "cubie_cube.h"
+
+
+// Fills moves with one scramble, called concurrently with a per-thread rng
+using ScrambleGenerator = std::function<void(std::mt19937_64& rng, std::vector<Move>& moves)>;
+
+// Same distribution as RubiksCube::shuffle(): uniform axis, side and direction per step
+auto shuffleGenerator(int steps) -> ScrambleGenerator;
+
+// Uniform random turns, never turning the same face twice in a row
+auto noRepeatGenerator(int steps) -> ScrambleGenerator;
+
+// Lower bound on the quarter turns to solve, max of small coordinate distance tables
+// (corner twist, edge flip, corner permutation) and the misplaced piece count / 4
+auto distanceLowerBound(const CubieCube& cube) -> int;
+
+// Counts per thread, merged after all workers finished
+struct ScrambleAccumulator {
+    static constexpr int maxDistance = 16;
+
+    std::uint64_t samples = 0;
+    std::uint64_t solved = 0;
+    std::array<std::array<std::uint64_t, cornerCount>, cornerCount> cornerPosition{};  // [piece][slot]
+    std::array<std::array<std::uint64_t, 3>, cornerCount> cornerOrientation{};         // [piece][twist]
+    std::array<std::array<std::uint64_t, edgeCount>, edgeCount> edgePosition{};        // [piece][slot]
+    std::array<std::array<std::uint64_t, 2>, edgeCount> edgeOrientation{};             // [piece][flip]
+    std::array<std::uint64_t, maxDistance + 1> distance{};                             // lower bound histogram
+
+    auto add(const CubieCube& cube) -> void;
+    auto merge(const ScrambleAccumulator& other) -> void;
+};
+
+struct ChiSquare {
+    double statistic;
+    int degreesOfFreedom;
+    double pValue;
+};
+
+// Pearson test of counts against a uniform distribution
+auto chiSquareUniform(const std::uint64_t* counts, int n) -> ChiSquare;
+
+struct ScrambleStatsConfig {
+    std::uint64_t scrambles = 1'000'000;
+    unsigned int threads = 0; // 0 = hardware concurrency
+    std::uint64_t seed = 1;
+};
+
+class ScrambleStats {
+public:
+    ScrambleStats(ScrambleGenerator generator, ScrambleStatsConfig config);
+
+    // Runs all scrambles, one accumulator per thread, and merges them
+    auto run() -> const ScrambleAccumulator&;
+
+    auto result() const -> const ScrambleAccumulator& { return m_result; }
+    auto threadsUsed() const -> unsigned int { return m_threadsUsed; }
+
+    auto report(std::ostream& out) const -> void;
+
+private:
+    ScrambleGenerator m_generator;
+    ScrambleStatsConfig m_config;
+    ScrambleAccumulator m_result;
+    unsigned int m_threadsUsed;
+};
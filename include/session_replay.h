@@ -0,0 +1,62 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "cube_state.h"
+#include "session_trace.h"
+#include "rubiks_cube.h"
+
+
+struct ReplayConfig {
+    float rotationSpeed = 200.0f;
+    float cubeSpacing = 1.02f;
+    float driftTolerance = 1e-3f;               // largest allowed distance of a cubie matrix from the exact grid
+    std::uint64_t settleFrameLimit = 1'000'000; // SETTLE gives up after this many frames
+    std::size_t maxReportedFailures = 64;
+};
+
+struct ReplayFailure {
+    enum class Kind : std::uint8_t {
+        GOLDEN,         // getCubeState() differs from a CHECK event
+        REFERENCE,      // getCubeState() differs from the queued turns applied to CubeState
+        MISCLASSIFIED,  // recomputeCubeState() from the cubie matrices differs from getCubeState()
+        DRIFT,          // a cubie matrix is further than driftTolerance from the grid
+        SETTLE          // the cube did not come to rest within settleFrameLimit frames
+    };
+
+    Kind kind;
+    std::size_t event;      // index into SessionTrace::events()
+    std::uint64_t frame;    // update() calls so far
+    int facelets;           // stickers that differ
+    float drift;
+};
+
+struct ReplayReport {
+    std::uint64_t frames = 0;
+    std::uint64_t turns = 0;
+    std::uint64_t checkpoints = 0;
+    std::uint64_t failureCount = 0;
+    std::vector<ReplayFailure> failures;    // the first maxReportedFailures
+    float maxDrift = 0.0f;
+    double simulatedSeconds = 0.0;          // sum of all deltaTimes
+    double seconds = 0.0;
+
+    auto passed() const -> bool { return failureCount == 0; }
+    auto speedup() const -> double { return seconds > 0.0 ? simulatedSeconds / seconds : 0.0; }
+};
+
+// Feeds the trace into a fresh RubiksCube without a window. Checkpoints are every CHECK
+// event, every time the cube comes to rest and the end of the trace.
+auto replaySession(const SessionTrace& trace, const ReplayConfig& config = {}) -> ReplayReport;
+
+// Largest distance of a model matrix entry from the exact grid: rotation entries from
+// -1/0/1, positions from multiples of cubeSpacing
+auto cubeDrift(const RubiksCube& cube, float cubeSpacing) -> float;
+
+auto replayFailureName(ReplayFailure::Kind kind) -> const char*;
+
+// Synthetic session with jittery frame times, bursts of queued turns, undo turns, pauses
+// and state jumps. Every burst ends with a settle and a check computed on CubeState alone.
+auto randomSessionTrace(std::size_t turns, std::uint64_t seed) -> SessionTrace;
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <filesystem>
+
+#include "cube_state.h"
+
+
+// Everything that drives a RubiksCube, in call order: the deltaTime of every update(),
+// the turns and pauses queued and the states jumped to. Replaying the events on a fresh
+// cube repeats the session frame by frame. CHECK events hold golden states.
+struct TraceEvent {
+    enum class Type : std::uint8_t { FRAME, TURN, PAUSE, STATE, SETTLE, CHECK };
+
+    Type type = Type::FRAME;
+    float deltaTime = 0.0f;         // FRAME, SETTLE: update() argument, PAUSE: seconds
+    std::uint32_t repeat = 1;       // FRAME: consecutive frames with the same deltaTime
+    Move move = Move::FRONT;        // TURN
+    bool record = true;             // TURN: false for undo/redo turns
+    float speed = 0.0f;             // TURN: RotationConfig::speed, 0 for the cube's default
+    CubeState state{};              // STATE, CHECK
+};
+
+// Text format, one event per line, '#' starts a comment:
+//   frames 240 0.00694444450    update() 240 times
+//   turn R'                     queue a turn, "turn R' norecord" for undo/redo turns,
+//                               "turn R' speed 400" with a speed other than the default
+//   pause 0.75                  queue a pause
+//   state <54 facelets>         setCubeState()
+//   settle 0.0166666675         update() until the cube is idle, for generated traces
+//   check <54 facelets>         golden getCubeState() at this point
+class SessionTrace {
+public:
+    auto addFrame(float deltaTime) -> void;
+    auto addTurn(Move move, bool record = true, float speed = 0.0f) -> void;
+    auto addPause(float seconds) -> void;
+    auto addState(const CubeState& state) -> void;
+    auto addSettle(float deltaTime) -> void;
+    auto addCheck(const CubeState& state) -> void;
+
+    auto events() const -> const std::vector<TraceEvent>& { return m_events; }
+    auto empty() const -> bool { return m_events.empty(); }
+    auto clear() -> void { m_events.clear(); }
+
+    // Throws std::runtime_error with the line number on malformed input
+    static auto load(const std::filesystem::path& path) -> SessionTrace;
+    auto save(const std::filesystem::path& path) const -> bool;
+
+private:
+    std::vector<TraceEvent> m_events;
+};
@@ -2,10 +2,12 @@
 
 
 #include <string>
+#include <string_view>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <filesystem>
+#include <cstdint>
 
 #include <glm/glm.hpp>
 
@@ -23,10 +25,25 @@ static std::string readTextFile(const std::filesystem::path& path) {
 }
 
 
+// GLSL sources of one program, usually the embedded ones from embedded_shaders.h
+struct ShaderSource {
+    std::string_view name;
+    std::string_view vertex;
+    std::string_view fragment;
+};
+
+
 class Shader {
 public:
+    // Compiles the files on every call, handy while editing shaders
     Shader(const std::filesystem::path& vertexPath, const std::filesystem::path& fragmentPath);
 
+    // With a cache directory the linked program binary is stored there, keyed by the
+    // driver (vendor, renderer, version) and a hash of the sources, and loaded with
+    // glProgramBinary on the next start instead of compiling. Stale or rejected
+    // binaries fall back to compiling and are replaced.
+    Shader(const ShaderSource& source, const std::filesystem::path& cacheDirectory = {});
+
     void use();
     void deleteShader();
 
@@ -50,4 +67,10 @@ public:
     void setMat4(const std::string& name, const glm::mat4& value) const;
 
     unsigned int ID;
+    bool loadedFromCache = false;
+
+private:
+    void compile(std::string_view vertexSource, std::string_view fragmentSource, bool retrievable);
+    bool loadBinary(const std::filesystem::path& path, std::uint64_t key);
+    void storeBinary(const std::filesystem::path& path, std::uint64_t key) const;
 };
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <optional>
+
+#include "cube_state.h"
+#include "cubie_cube.h"
+
+
+// Binary protocol of the solve daemon (tools/solve_daemon.cpp) over a Unix domain socket.
+// Integers are little endian. Every message is one frame:
+//   u32 size of the rest, u8 SolveMessage, u32 request id, payload
+// Payloads:
+//   SOLVE_MOVES  u8 SolverKind, u16 count, count Move bytes (scramble from solved)
+//   SOLVE_STATE  u8 SolverKind, PackedState (9 bytes)
+//   STATS        empty
+//   SOLUTION     u8 SolveStatus, u32 solve time in us, u8 stage count,
+//                per stage u8 label size, label, u16 move count, Move bytes
+//   STATS_REPLY  u8 counter count, u64 counters in SolveStats order
+// Responses carry the id of their request and may arrive in any order.
+
+enum class SolveMessage : std::uint8_t {
+    SOLVE_MOVES = 0x01,
+    SOLVE_STATE = 0x02,
+    STATS = 0x03,
+    SOLUTION = 0x81,
+    STATS_REPLY = 0x83
+};
+
+enum class SolverKind : std::uint8_t { CFOP, OPTIMAL };
+
+enum class SolveStatus : std::uint8_t {
+    OK,
+    FAILED,      // unsolvable state or no solution within the daemon's limits
+    BAD_REQUEST, // malformed payload
+    REJECTED     // the daemon's queue was full, nothing was solved, retry later
+};
+
+constexpr std::uint32_t maxFrameSize = 1 << 16;
+constexpr std::size_t maxScrambleLength = 4096;
+
+struct SolveFrame {
+    SolveMessage type;
+    std::uint32_t id;
+    std::vector<std::uint8_t> payload;
+};
+
+struct SolveRequest {
+    std::uint32_t id = 0;
+    SolverKind solver = SolverKind::CFOP;
+    std::vector<Move> scramble;         // used if state is empty
+    std::optional<PackedState> state;
+};
+
+struct SolveResponse {
+    std::uint32_t id = 0;
+    SolveStatus status = SolveStatus::OK;
+    std::uint32_t solveMicros = 0;
+    std::vector<SolveStage> stages;
+};
+
+// Counters of a running daemon, latencies from receiving a request to queuing its solution for sending
+struct SolveStats {
+    std::uint64_t uptimeMillis = 0;
+    std::uint64_t connections = 0;
+    std::uint64_t requests = 0;
+    std::uint64_t solved = 0;
+    std::uint64_t failed = 0;
+    std::uint64_t badRequests = 0;          // requests answered with BAD_REQUEST
+    std::uint64_t batches = 0;
+    std::uint64_t latencyMeanMicros = 0;
+    std::uint64_t latencyP50Micros = 0;
+    std::uint64_t latencyP99Micros = 0;
+    std::uint64_t latencyMaxMicros = 0;
+    std::uint64_t overloaded = 0;           // requests answered with REJECTED
+};
+
+// solve.sock in the private userRuntimeDirectory, empty if there is none
+auto defaultSolveSocket() -> std::string;
+
+auto encodeRequest(const SolveRequest& request) -> SolveFrame;
+auto decodeRequest(const SolveFrame& frame) -> std::optional<SolveRequest>;
+
+auto encodeResponse(const SolveResponse& response) -> SolveFrame;
+auto decodeResponse(const SolveFrame& frame) -> std::optional<SolveResponse>;
+
+auto encodeStats(std::uint32_t id, const SolveStats& stats) -> SolveFrame;
+auto decodeStats(const SolveFrame& frame) -> std::optional<SolveStats>;
+
+// Appends the wire format of frame to out
+auto appendFrame(std::vector<std::uint8_t>& out, const SolveFrame& frame) -> void;
+
+// Blocking frame I/O on a connected socket, false / std::nullopt once the peer is gone
+auto sendBytes(int fd, const std::vector<std::uint8_t>& bytes) -> bool;
+auto sendFrame(int fd, const SolveFrame& frame) -> bool;
+auto receiveFrame(int fd) -> std::optional<SolveFrame>;
+
+// Client side of the protocol, requests can be pipelined with submit() and receive()
+class SolveClient {
+public:
+    // Throws std::runtime_error if the daemon is not listening on socketPath
+    explicit SolveClient(const std::string& socketPath);
+    ~SolveClient();
+
+    SolveClient(const SolveClient&) = delete;
+    auto operator=(const SolveClient&) -> SolveClient& = delete;
+
+    // Returns the request id
+    auto submit(const std::vector<Move>& scramble, SolverKind solver = SolverKind::CFOP) -> std::uint32_t;
+    auto submit(const CubieCube& cube, SolverKind solver = SolverKind::CFOP) -> std::uint32_t;
+
+    // Next solution from the daemon, throws std::runtime_error if the connection was lost
+    auto receive() -> SolveResponse;
+
+    // The blocking calls below are only valid without other requests in flight
+    auto solve(const std::vector<Move>& scramble, SolverKind solver = SolverKind::CFOP) -> SolveResponse;
+    auto stats() -> SolveStats;
+
+private:
+    auto send(const SolveFrame& frame) -> void;
+    auto receive(SolveMessage type) -> SolveFrame;
+
+    int m_fd;
+    std::uint32_t m_nextId;
+};
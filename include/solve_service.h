@@ -0,0 +1,104 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "cfop_solver.h"
+#include "solve_protocol.h"
+
+
+struct SolveServiceConfig {
+    std::string socketPath = defaultSolveSocket();
+    unsigned int workers = 0;                                   // 0 = hardware concurrency
+    std::size_t maxBatch = 64;                                  // requests per batch
+    std::chrono::microseconds batchDelay{ 200 };                // how long a batch waits to fill up
+    std::size_t maxQueued = 16384;                              // unsolved requests, more are answered with REJECTED
+    std::size_t maxOutbox = std::size_t(1) << 22;               // unsent reply bytes per connection before it is dropped
+    std::chrono::milliseconds sendTimeout{ 5000 };              // a client that reads nothing for this long is dropped
+    int optimalMaxDepth = 14;                                   // quarter turns
+    std::size_t optimalMemoryLimit = std::size_t(1) << 30;      // bytes, optimal solves run one at a time
+};
+
+// Solve daemon: keeps the solver tables resident and serves SolveClients over a Unix
+// domain socket. A reader thread per connection decodes requests into one bounded queue,
+// a dispatcher coalesces them into batches and splits every batch across the worker pool,
+// and every worker posts the solutions of its slice to the outbox of each connection.
+// A writer thread per connection drains its outbox, so a client that stops reading only
+// stalls itself and is dropped once its outbox or send timeout runs out.
+class SolveService {
+public:
+    // Builds the solver tables, throws std::runtime_error if the socket cannot be bound
+    // or another daemon is already listening on it
+    explicit SolveService(SolveServiceConfig config);
+    ~SolveService();
+
+    SolveService(const SolveService&) = delete;
+    auto operator=(const SolveService&) -> SolveService& = delete;
+
+    // Serves until stop is set, then closes all connections and joins the threads
+    auto run(const std::atomic<bool>& stop) -> void;
+
+    auto stats() const -> SolveStats;
+
+private:
+    struct Connection;
+
+    struct PendingRequest {
+        SolveRequest request;
+        std::shared_ptr<Connection> connection;
+        std::chrono::steady_clock::time_point received;
+    };
+
+    using Batch = std::vector<PendingRequest>;
+
+    // power of two microsecond buckets
+    static constexpr int latencyBucketCount = 40;
+
+    auto readConnection(std::shared_ptr<Connection> connection) -> void;
+    auto writeConnection(std::shared_ptr<Connection> connection) -> void;
+    auto dispatch() -> void;
+    auto work() -> void;
+
+    auto solve(const SolveRequest& request) -> SolveResponse;
+    auto recordLatency(std::chrono::steady_clock::duration latency) -> void;
+
+private:
+    SolveServiceConfig m_config;
+    CfopSolver m_cfop;
+    std::mutex m_optimalMutex;
+    int m_listenFd;
+    std::chrono::steady_clock::time_point m_start;
+
+    std::mutex m_queueMutex;
+    std::condition_variable m_pendingCondition;
+    std::condition_variable m_batchCondition;
+    std::deque<PendingRequest> m_pending;
+    std::deque<Batch> m_batches;
+    std::size_t m_queued;               // requests in m_pending and m_batches
+    unsigned int m_workerCount;
+    bool m_stopping;
+
+    std::list<std::pair<std::shared_ptr<Connection>, std::thread>> m_readers;
+    std::thread m_dispatcher;
+    std::vector<std::thread> m_workers;
+
+    std::atomic<std::uint64_t> m_connections;
+    std::atomic<std::uint64_t> m_requests;
+    std::atomic<std::uint64_t> m_solved;
+    std::atomic<std::uint64_t> m_failed;
+    std::atomic<std::uint64_t> m_badRequests;
+    std::atomic<std::uint64_t> m_overloaded;
+    std::atomic<std::uint64_t> m_batchCount;
+    std::atomic<std::uint64_t> m_latencyTotal;
+    std::atomic<std::uint64_t> m_latencyMax;
+    std::array<std::atomic<std::uint64_t>, latencyBucketCount> m_latencyBuckets;
+};
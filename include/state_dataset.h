@@ -0,0 +1,112 @@
+#pragma once
+
+#include <span>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <fstream>
+#include <filesystem>
+
+#include "cubie_cube.h"
+
+
+// Columnar file of cube states for large datasets.
+//
+// Layout (little endian):
+//   header      64 bytes, see DatasetHeader
+//   columns     32 bytes per column, column 0 is always "state" (PackedState, 9 bytes)
+//   blocks      starting at dataOffset, rowsPerBlock rows each (the last one may be shorter);
+//               inside a block every column is stored contiguously, each segment padded to 64 bytes
+//
+// Blocks can be written as a stream and the whole file is read through a memory
+// mapping, so columns come back as spans into the file without any copy or parsing.
+
+struct DatasetColumnSpec {
+    std::string name;           // at most 23 characters
+    std::uint32_t elementSize;  // bytes per row
+};
+
+class StateDatasetWriter {
+public:
+    StateDatasetWriter(const std::filesystem::path& path, std::vector<DatasetColumnSpec> extraColumns = {}, std::size_t rowsPerBlock = std::size_t(1) << 20);
+    ~StateDatasetWriter();
+
+    StateDatasetWriter(const StateDatasetWriter&) = delete;
+    auto operator=(const StateDatasetWriter&) -> StateDatasetWriter& = delete;
+
+    // extra holds the values of all extra columns of the row, in column order
+    auto append(const PackedState& state, std::span<const std::uint8_t> extra = {}) -> void;
+
+    // Flushes the last block and writes the final row count, called by the destructor
+    auto close() -> void;
+
+    auto rowCount() const -> std::uint64_t { return m_rowCount; }
+
+private:
+    auto flushBlock() -> void;
+
+    std::ofstream m_file;
+    std::vector<DatasetColumnSpec> m_columns;
+    std::vector<std::vector<std::uint8_t>> m_buffers;
+    std::size_t m_rowsPerBlock;
+    std::size_t m_rowsInBlock;
+    std::uint64_t m_rowCount;
+    std::size_t m_extraSize;
+};
+
+class StateDataset {
+public:
+    // Maps the file read only, throws std::runtime_error if it is missing or malformed
+    explicit StateDataset(const std::filesystem::path& path);
+    ~StateDataset();
+
+    StateDataset(const StateDataset&) = delete;
+    auto operator=(const StateDataset&) -> StateDataset& = delete;
+
+    auto rowCount() const -> std::uint64_t { return m_rowCount; }
+    auto rowsPerBlock() const -> std::uint64_t { return m_rowsPerBlock; }
+    auto blockCount() const -> std::uint64_t { return (m_rowCount + m_rowsPerBlock - 1) / m_rowsPerBlock; }
+    auto columns() const -> const std::vector<DatasetColumnSpec>& { return m_columns; }
+
+    // -1 if there is no such column
+    auto columnIndex(const std::string& name) const -> int;
+
+    // Raw bytes of one column of one block
+    auto columnBytes(std::uint64_t block, int column) const -> std::span<const std::uint8_t>;
+
+    // Zero copy typed view, sizeof(T) has to match the element size
+    template <typename T>
+    auto column(std::uint64_t block, int column) const -> std::span<const T> {
+        auto bytes = columnBytes(block, column);
+        checkElementSize(column, sizeof(T));
+        return { reinterpret_cast<const T*>(bytes.data()), bytes.size() / sizeof(T) };
+    }
+
+    auto states(std::uint64_t block) const -> std::span<const PackedState> { return column<PackedState>(block, 0); }
+
+    auto state(std::uint64_t row) const -> const PackedState&;
+
+    // Calls f(const PackedState&) for every row in file order
+    template <typename F>
+    auto forEachState(F&& f) const -> void {
+        for (std::uint64_t b = 0; b < blockCount(); ++b) {
+            for (const auto& s : states(b)) f(s);
+        }
+    }
+
+private:
+    auto blockOffset(std::uint64_t block) const -> std::size_t;
+    auto checkElementSize(int column, std::size_t size) const -> void;
+    auto unmap() -> void;
+
+    const std::uint8_t* m_data;
+    std::size_t m_size;
+    void* m_mapping; // platform handle of the mapping
+
+    std::vector<DatasetColumnSpec> m_columns;
+    std::uint64_t m_rowCount;
+    std::uint64_t m_rowsPerBlock;
+    std::uint64_t m_dataOffset;
+    std::size_t m_fullBlockSize;
+};
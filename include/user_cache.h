@@ -0,0 +1,16 @@
+#pragma once
+
+#include <string>
+#include <filesystem>
+
+
+// Private cache directory of the current user: $XDG_CACHE_HOME/name, ~/.cache/name
+// without it, %LOCALAPPDATA%\name on Windows. The directory is created with mode 0700 and
+// only returned if this user owns it and nobody else can write to it. Otherwise the
+// result is empty and callers run without a cache, so other local users cannot plant
+// files that are loaded as cache entries.
+auto userCacheDirectory(const std::string& name) -> std::filesystem::path;
+
+// Private directory for sockets of the current user: $XDG_RUNTIME_DIR/name, the cache
+// directory above without it. Created and checked the same way, empty if unusable.
+auto userRuntimeDirectory(const std::string& name) -> std::filesystem::path;
@@ -1,28 +1,29 @@
 #version 460 core
 out vec4 FragColor;
 
-in float FaceIndex;
+in vec3 WorldPos;
+flat in uint ColorIndex;
 
-uniform int colorMask;
+// indexed by the colorMask bit of the face, 6 is the cubie body
+const vec3 palette[7] = vec3[](
+    vec3(0.0, 0.0, 1.0),    // Blue (Back)
+    vec3(0.0, 1.0, 0.0),    // Green (Front)
+    vec3(1.0, 0.5, 0.0),    // Orange (Left)
+    vec3(1.0, 0.0, 0.0),    // Red (Right)
+    vec3(1.0, 1.0, 0.0),    // Yellow (Bottom)
+    vec3(1.0, 1.0, 1.0),    // White (Top)
+    vec3(0.03, 0.03, 0.03)  // Black (Body)
+);
+
+const vec3 lightDirection = normalize(vec3(0.4, 0.8, 0.6));
 
 void main()
 {
-    // Colors for the faces
-    vec3 color;
-    int index = int(round(FaceIndex));
-
-    if ((colorMask & (1 << index)) == 0) {
-        color = vec3(0.0, 0.0, 0.0); // black internals
-    } else {
-        if (index == 0) color = vec3(0.0, 0.0, 1.0); // Blue (Back)
-        else if (index == 1) color = vec3(0.0, 1.0, 0.0); // Green (Front)
-        else if (index == 2) color = vec3(1.0, 0.5, 0.0); // Orange (Left)
-        else if (index == 3) color = vec3(1.0, 0.0, 0.0); // Red (Right)
-        else if (index == 4) color = vec3(1.0, 1.0, 0.0); // Yellow (Bottom)
-        else if (index == 5) color = vec3(1.0, 1.0, 1.0); // White (Top)
-        else color = vec3(0.0, 0.0, 0.0); // Black (Internal/Error)    
-    }
-
+    // every polygon is flat, so its normal follows from the screen space derivatives;
+    // back faces are culled, so it always points out of the cubie
+    vec3 normal = normalize(cross(dFdx(WorldPos), dFdy(WorldPos)));
 
-    FragColor = vec4(color, 1.0);
-}
\ No newline at end of file
+    // mostly ambient so the sticker colors stay flat, enough diffuse to show the bevels
+    float light = 0.6 + 0.4 * max(dot(normal, lightDirection), 0.0);
+    FragColor = vec4(palette[ColorIndex] * light, 1.0);
+}
@@ -1,15 +1,23 @@
 #version 460 core
-layout (location = 0) in vec3 aPos;
-layout (location = 1) in float aFaceIndex;
+layout (location = 0) in vec3 aPos;         // normalized shorts
+layout (location = 1) in uint aFaceId;      // 0..5 sticker of that colorMask face, 6 body
 
-out float FaceIndex;
+// per cubie
+layout (location = 3) in mat4 aModel;
+layout (location = 7) in uint aColorMask;
+
+out vec3 WorldPos;
+flat out uint ColorIndex;
 
-uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 
 void main()
 {
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
-    FaceIndex = aFaceIndex;
-}
\ No newline at end of file
+    vec4 worldPos = aModel * vec4(aPos, 1.0);
+    gl_Position = projection * view * worldPos;
+    WorldPos = worldPos.xyz;
+
+    // stickers on internal faces take the body color, they only show between turning layers
+    ColorIndex = (aFaceId < 6u && (aColorMask & (1u << aFaceId)) != 0u) ? aFaceId : 6u;
+}
@@ -0,0 +1,244 @@
+#include "bidirectional_solver.h"
+
+#include <thread>
+#include <algorithm>
+
+#include "profiler.h"
+
+
+namespace {
+
+constexpr int noMove = 15;
+
+// Open addressing set of CubieKeys. The key only uses the low 27 bits of corners,
+// the upper bits hold the move that reached the state, its depth and an occupied flag.
+class StateSet {
+public:
+    struct Entry {
+        std::uint64_t corners = 0;
+        std::uint64_t edges = 0;
+
+        auto key() const -> CubieKey { return CubieKey{ corners & keyMask, edges }; }
+        auto move() const -> int { return static_cast<int>((corners >> 32) & 0xf); }
+        auto depth() const -> int { return static_cast<int>((corners >> 40) & 0xff); }
+        auto occupied() const -> bool { return (corners >> 63) != 0; }
+    };
+
+    static constexpr std::uint64_t keyMask = (std::uint64_t(1) << 32) - 1;
+
+    StateSet() : m_entries(1024), m_size{ 0 } {}
+
+    auto find(const CubieKey& key) const -> const Entry* {
+        auto mask = m_entries.size() - 1;
+        for (auto i = hash(key) & mask;; i = (i + 1) & mask) {
+            const auto& e = m_entries[i];
+            if (!e.occupied()) return nullptr;
+            if (e.key() == key) return &e;
+        }
+    }
+
+    // false if the key is already present
+    auto insert(const CubieKey& key, int move, int depth) -> bool {
+        if ((m_size + 1) * 2 > m_entries.size()) grow();
+
+        auto mask = m_entries.size() - 1;
+        for (auto i = hash(key) & mask;; i = (i + 1) & mask) {
+            auto& e = m_entries[i];
+            if (!e.occupied()) {
+                e.corners = key.corners
+                    | (static_cast<std::uint64_t>(move) << 32)
+                    | (static_cast<std::uint64_t>(depth) << 40)
+                    | (std::uint64_t(1) << 63);
+                e.edges = key.edges;
+                ++m_size;
+                return true;
+            }
+            if (e.key() == key) return false;
+        }
+    }
+
+    auto size() const -> std::size_t { return m_size; }
+    auto memory() const -> std::size_t { return m_entries.size() * sizeof(Entry); }
+
+    // memory after inserting `count` more states
+    auto memoryWith(std::size_t count) const -> std::size_t {
+        auto capacity = m_entries.size();
+        while ((m_size + count) * 2 > capacity) capacity *= 2;
+        return capacity * sizeof(Entry);
+    }
+
+private:
+    static auto hash(const CubieKey& key) -> std::size_t {
+        // splitmix64 finalizer
+        auto x = key.edges * 0x9e3779b97f4a7c15ull ^ key.corners;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+        return static_cast<std::size_t>(x ^ (x >> 31));
+    }
+
+    auto grow() -> void {
+        std::vector<Entry> old(m_entries.size() * 2);
+        old.swap(m_entries);
+        m_size = 0;
+
+        for (const auto& e : old) {
+            if (e.occupied()) insert(e.key(), e.move(), e.depth());
+        }
+    }
+
+    std::vector<Entry> m_entries;
+    std::size_t m_size;
+};
+
+struct Candidate {
+    CubieKey key;
+    int move;
+};
+
+struct Meeting {
+    CubieKey key;
+    int length;
+};
+
+// Moves from the root of `set` to the state `key`
+auto pathFromRoot(const StateSet& set, CubieKey key) -> std::vector<Move> {
+    std::vector<Move> path;
+
+    for (auto e = set.find(key); e && e->move() != noMove; e = set.find(key)) {
+        auto move = static_cast<Move>(e->move());
+        path.push_back(move);
+
+        auto cube = cubieFromKey(key);
+        applyMove(cube, inverseMove(move));
+        key = cubieKey(cube);
+    }
+
+    std::reverse(path.begin(), path.end());
+    return path;
+}
+
+} // namespace
+
+
+BidirectionalSolver::BidirectionalSolver(BidirectionalSolverConfig config) :
+    m_config{ config },
+    m_stats{}
+{
+}
+
+auto BidirectionalSolver::solve(const CubeState& state) -> std::optional<std::vector<Move>> {
+    return solve(cubieFromState(state));
+}
+
+auto BidirectionalSolver::solve(const CubieCube& cube) -> std::optional<std::vector<Move>> {
+    PROFILE_SCOPE("BidirectionalSolver::solve");
+
+    m_stats = BidirectionalSolverStats{};
+    if (!isSolvable(cube)) return std::nullopt;
+
+    auto startKey = cubieKey(cube);
+    auto solvedKey = cubieKey(solvedCubieCube());
+    if (startKey == solvedKey) return std::vector<Move>{};
+
+    auto threads = m_config.threads;
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+
+    // side 0 grows from the scramble, side 1 from solved
+    StateSet sets[2];
+    std::vector<StateSet::Entry> frontiers[2];
+    int depths[2] = { 0, 0 };
+
+    for (int side = 0; side < 2; ++side) {
+        auto key = (side == 0) ? startKey : solvedKey;
+        sets[side].insert(key, noMove, 0);
+        frontiers[side].push_back(*sets[side].find(key));
+    }
+
+    while (depths[0] + depths[1] < m_config.maxDepth) {
+        int side = (frontiers[0].size() <= frontiers[1].size()) ? 0 : 1;
+        auto& own = sets[side];
+        const auto& other = sets[1 - side];
+        const auto& frontier = frontiers[side];
+
+        // at most 11 new states per frontier state (no immediate undo)
+        auto expected = frontier.size() * (moveCount - 1);
+        auto projected = own.memoryWith(expected) + other.memory()
+            + expected * (sizeof(Candidate) + sizeof(StateSet::Entry))
+            + frontiers[1 - side].size() * sizeof(StateSet::Entry);
+        m_stats.peakMemory = std::max(m_stats.peakMemory, projected);
+        if (projected > m_config.memoryLimit) {
+            m_stats.memoryLimitHit = true;
+            return std::nullopt;
+        }
+
+        // expand in parallel, the sets are only read until all workers joined
+        auto workerCount = static_cast<unsigned int>(std::min<std::size_t>(threads, frontier.size() / 256 + 1));
+        std::vector<std::vector<Candidate>> candidates(workerCount);
+        std::vector<std::vector<Meeting>> meetings(workerCount);
+
+        auto expand = [&](unsigned int worker) {
+            auto begin = frontier.size() * worker / workerCount;
+            auto end = frontier.size() * (worker + 1) / workerCount;
+
+            for (auto i = begin; i < end; ++i) {
+                auto parent = cubieFromKey(frontier[i].key());
+                auto parentMove = frontier[i].move();
+
+                for (int m = 0; m < moveCount; ++m) {
+                    if (parentMove != noMove && (m ^ 1) == parentMove) continue;
+
+                    auto child = parent;
+                    applyMove(child, static_cast<Move>(m));
+                    auto key = cubieKey(child);
+                    if (own.find(key)) continue;
+
+                    candidates[worker].push_back(Candidate{ key, m });
+                    if (auto e = other.find(key)) {
+                        meetings[worker].push_back(Meeting{ key, depths[side] + 1 + e->depth() });
+                    }
+                }
+            }
+        };
+
+        if (workerCount == 1) {
+            expand(0);
+        }
+        else {
+            std::vector<std::thread> workers;
+            for (unsigned int w = 0; w < workerCount; ++w) workers.emplace_back(expand, w);
+            for (auto& worker : workers) worker.join();
+        }
+
+        ++depths[side];
+
+        std::vector<StateSet::Entry> next;
+        for (const auto& list : candidates) {
+            for (const auto& c : list) {
+                if (own.insert(c.key, c.move, depths[side])) next.push_back(*own.find(c.key));
+            }
+        }
+        frontiers[side].swap(next);
+        m_stats.statesVisited = sets[0].size() + sets[1].size();
+
+        // every meeting of this level is at most one longer than any other, take the shortest
+        const Meeting* best = nullptr;
+        for (const auto& list : meetings) {
+            for (const auto& meeting : list) {
+                if (!best || meeting.length < best->length) best = &meeting;
+            }
+        }
+
+        if (best) {
+            auto forward = pathFromRoot(sets[0], best->key);
+            auto backward = pathFromRoot(sets[1], best->key);
+
+            // the solved side was grown from solved, walk it back
+            for (auto it = backward.rbegin(); it != backward.rend(); ++it) forward.push_back(inverseMove(*it));
+            return forward;
+        }
+
+        if (frontiers[side].empty()) break;
+    }
+
+    return std::nullopt;
+}
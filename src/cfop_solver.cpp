@@ -0,0 +1,401 @@
+#include "cfop_solver.h"
+
+#include <queue>
+#include <iterator>
+#include <stdexcept>
+#include <algorithm>
+
+#include "profiler.h"
+
+
+namespace {
+
+constexpr int crossEdges[4] = { 4, 5, 6, 7 };            // DR, DF, DL, DB
+constexpr int pairCorners[4] = { 4, 5, 6, 7 };           // DFR, DLF, DBL, DRB
+constexpr int pairEdges[4] = { 8, 9, 10, 11 };           // FR, FL, BL, BR
+constexpr const char* pairNames[4] = { "FR", "FL", "BL", "BR" };
+
+// Short well known algorithms that keep the first two layers intact,
+// the last layer tables are searched over combinations of these
+constexpr const char* ollGenerators[] = {
+    "U", "U'",
+    "R U R' U R U2 R'",         // sune
+    "R U2 R' U' R U' R'",       // anti sune
+    "L' U' L U' L' U2 L",       // left sune
+    "F R U R' U' F'",
+    "F U R U' R' F'",
+    "R U R' U' R' F R F'",
+    "R U R' U R U' R' U R U2 R'",   // double sune
+    "R U2 R2 U' R2 U' R2 U2 R",      // pi
+};
+
+constexpr const char* pllGenerators[] = {
+    "U", "U'",
+    "R U R' U' R' F R2 U' R' U' R U R' F'",        // T
+    "R U' R U R U R U' R' U' R2",                  // Ua
+    "R2 U R U R' U' R' U' R' U R'",                // Ub
+    "F R U' R' U' R U R' F' R U R' U' R' F R F'",  // Y
+    "R U R' F' R U R' U' R' F R2 U' R' U'",        // Jb
+    "R' U L' U2 R U' R' U2 R L",                   // Ja
+    "R' F R' B2 R F' R' B2 R2",                    // Aa
+    "R2 B2 R F R' B2 R F' R",                      // Ab
+    "R' U' F' R U R' U' R' F R2 U' R' U' R U R' U R",  // F
+};
+
+auto keepsFirstTwoLayers(const CubieCube& cube) -> bool {
+    for (int i = 4; i < cornerCount; ++i) {
+        if (cube.cornerPerm[i] != i || cube.cornerOrient[i] != 0) return false;
+    }
+    for (int i = 4; i < edgeCount; ++i) {
+        if (cube.edgePerm[i] != i || cube.edgeOrient[i] != 0) return false;
+    }
+    return true;
+}
+
+auto invert(const std::vector<Move>& moves) -> std::vector<Move> {
+    std::vector<Move> result;
+    for (auto it = moves.rbegin(); it != moves.rend(); ++it) result.push_back(inverseMove(*it));
+    return result;
+}
+
+// Cancels X X' and turns X X X into X'
+auto simplify(const std::vector<Move>& moves) -> std::vector<Move> {
+    std::vector<Move> result;
+
+    for (auto move : moves) {
+        auto n = result.size();
+        if (n >= 1 && result[n - 1] == inverseMove(move)) {
+            result.pop_back();
+        }
+        else if (n >= 2 && result[n - 1] == move && result[n - 2] == move) {
+            result.resize(n - 2);
+            result.push_back(inverseMove(move));
+        }
+        else {
+            result.push_back(move);
+        }
+    }
+
+    return result;
+}
+
+// Skip sequences with a redundant equivalent: undoing the last move, the same
+// move three times, and commuting opposite faces in descending order
+auto isRedundant(Move move, int prev, int prev2) -> bool {
+    if (prev < 0) return false;
+
+    int m = static_cast<int>(move);
+    if ((m ^ 1) == prev) return true;
+    if (m == prev && m == prev2) return true;
+
+    int face = m / 2;
+    int prevFace = prev / 2;
+    return face != prevFace && face / 2 == prevFace / 2 && face < prevFace;
+}
+
+} // namespace
+
+
+// Location of every piece as slot * 3 + twist (corners) or slot * 2 + flip (edges), 0..23
+struct CfopSolver::PieceLocations {
+    std::uint8_t corners[cornerCount];
+    std::uint8_t edges[edgeCount];
+
+    explicit PieceLocations(const CubieCube& cube) {
+        for (int slot = 0; slot < cornerCount; ++slot) {
+            corners[cube.cornerPerm[slot]] = static_cast<std::uint8_t>(slot * 3 + cube.cornerOrient[slot]);
+        }
+        for (int slot = 0; slot < edgeCount; ++slot) {
+            edges[cube.edgePerm[slot]] = static_cast<std::uint8_t>(slot * 2 + cube.edgeOrient[slot]);
+        }
+    }
+};
+
+// Exact distance to bring a few pieces home, index is the base 24 number of their locations
+struct CfopSolver::PieceTable {
+    std::vector<int> corners;
+    std::vector<int> edges;
+    std::vector<std::uint8_t> distance;
+
+    PieceTable(std::vector<int> cornerPieces, std::vector<int> edgePieces) :
+        corners{ std::move(cornerPieces) },
+        edges{ std::move(edgePieces) },
+        distance{}
+    {
+        // location digit after a move, per move and current location
+        std::uint8_t cornerNext[moveCount][24];
+        std::uint8_t edgeNext[moveCount][24];
+        for (int m = 0; m < moveCount; ++m) {
+            const auto& mc = moveCubie(static_cast<Move>(m));
+            for (int i = 0; i < cornerCount; ++i) {
+                for (int twist = 0; twist < 3; ++twist) {
+                    cornerNext[m][mc.cornerPerm[i] * 3 + twist] = static_cast<std::uint8_t>(i * 3 + (twist + mc.cornerOrient[i]) % 3);
+                }
+            }
+            for (int i = 0; i < edgeCount; ++i) {
+                for (int flip = 0; flip < 2; ++flip) {
+                    edgeNext[m][mc.edgePerm[i] * 2 + flip] = static_cast<std::uint8_t>(i * 2 + (flip ^ mc.edgeOrient[i]));
+                }
+            }
+        }
+
+        auto pieces = corners.size() + edges.size();
+        int size = 1;
+        for (std::size_t i = 0; i < pieces; ++i) size *= 24;
+        distance.assign(size, 0xff);
+
+        int solved = 0;
+        for (auto c : corners) solved = solved * 24 + c * 3;
+        for (auto e : edges) solved = solved * 24 + e * 2;
+        distance[solved] = 0;
+
+        std::vector<int> frontier{ solved };
+        std::vector<int> next;
+        std::vector<std::uint8_t> digits(pieces);
+
+        for (std::uint8_t depth = 0; !frontier.empty(); ++depth) {
+            next.clear();
+            for (auto coord : frontier) {
+                for (auto i = pieces; i-- > 0;) {
+                    digits[i] = static_cast<std::uint8_t>(coord % 24);
+                    coord /= 24;
+                }
+
+                for (int m = 0; m < moveCount; ++m) {
+                    int c = 0;
+                    for (std::size_t i = 0; i < pieces; ++i) {
+                        c = c * 24 + (i < corners.size() ? cornerNext[m][digits[i]] : edgeNext[m][digits[i]]);
+                    }
+                    if (distance[c] == 0xff) {
+                        distance[c] = depth + 1;
+                        next.push_back(c);
+                    }
+                }
+            }
+            frontier.swap(next);
+        }
+    }
+
+    auto lookup(const PieceLocations& loc) const -> int {
+        int c = 0;
+        for (auto piece : corners) c = c * 24 + loc.corners[piece];
+        for (auto piece : edges) c = c * 24 + loc.edges[piece];
+        return distance[c];
+    }
+};
+
+
+CfopSolver::CfopSolver() :
+    m_crossTable{ std::make_unique<PieceTable>(std::vector<int>{}, std::vector<int>(std::begin(crossEdges), std::end(crossEdges))) },
+    m_pairTables(4),
+    m_oll{},
+    m_pll{}
+{
+    for (int pair = 0; pair < 4; ++pair) {
+        for (int a = 0; a < 4; ++a) {
+            for (int b = a + 1; b < 4; ++b) {
+                m_pairTables[pair].emplace_back(
+                    std::vector<int>{ pairCorners[pair] },
+                    std::vector<int>{ pairEdges[pair], crossEdges[a], crossEdges[b] }
+                );
+            }
+        }
+    }
+
+    buildLastLayerTables();
+}
+
+CfopSolver::~CfopSolver() = default;
+
+auto CfopSolver::solve(const CubeState& state) const -> std::vector<SolveStage> {
+    return solve(cubieFromState(state));
+}
+
+auto CfopSolver::solve(const CubieCube& start) const -> std::vector<SolveStage> {
+    PROFILE_SCOPE("CfopSolver::solve");
+
+    std::vector<SolveStage> stages;
+    auto cube = start;
+
+    stages.push_back(SolveStage{ "cross", solveCross(cube) });
+
+    auto pairsSolved = [this](const CubieCube& c) {
+        auto loc = PieceLocations(c);
+        unsigned int solved = 0;
+        for (int pair = 0; pair < 4; ++pair) {
+            if (pairBound(loc, pair) == 0) solved |= (1u << pair);
+        }
+        return solved;
+    };
+
+    // always insert the pair with the shortest solution next
+    unsigned int solvedPairs = pairsSolved(cube);
+    while (solvedPairs != 0xf) {
+        std::vector<Move> moves;
+        int solved = -1;
+
+        for (int bound = 0; bound <= maxPairDepth && solved < 0; ++bound) {
+            for (int pair = 0; pair < 4 && solved < 0; ++pair) {
+                if (solvedPairs & (1u << pair)) continue;
+
+                moves.clear();
+                if (solvePair(cube, pair, bound, solvedPairs, moves)) solved = pair;
+            }
+        }
+
+        if (solved < 0) throw std::runtime_error("no F2L pair found within the depth limit!");
+
+        for (auto move : moves) applyMove(cube, move);
+        stages.push_back(SolveStage{ std::string("f2l ") + pairNames[solved], moves });
+
+        solvedPairs = pairsSolved(cube);
+    }
+
+    auto oll = m_oll.find(ollKey(stateFromCubie(cube)));
+    if (oll == m_oll.end()) throw std::runtime_error("unknown OLL case!");
+    for (auto move : oll->second) applyMove(cube, move);
+    stages.push_back(SolveStage{ "oll", oll->second });
+
+    auto pll = m_pll.find(pllKey(stateFromCubie(cube)));
+    if (pll == m_pll.end()) throw std::runtime_error("unknown PLL case!");
+    stages.push_back(SolveStage{ "pll", pll->second });
+
+    return stages;
+}
+
+// Which last layer stickers show the top color: 9 top + 3 on each side face
+auto CfopSolver::ollKey(const CubeState& state) -> std::uint32_t {
+    auto up = state.top[1][1];
+    std::uint32_t key = 0;
+
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) key = (key << 1) | (state.top[i][j] == up ? 1u : 0u);
+    }
+    for (int j = 0; j < 3; ++j) {
+        key = (key << 1) | (state.front[0][j] == up ? 1u : 0u);
+        key = (key << 1) | (state.right[0][j] == up ? 1u : 0u);
+        key = (key << 1) | (state.back[0][j] == up ? 1u : 0u);
+        key = (key << 1) | (state.left[0][j] == up ? 1u : 0u);
+    }
+
+    return key;
+}
+
+// Colors of the 12 last layer side stickers, 3 bits each
+auto CfopSolver::pllKey(const CubeState& state) -> std::uint64_t {
+    std::uint64_t key = 0;
+
+    for (int j = 0; j < 3; ++j) {
+        key = (key << 3) | static_cast<std::uint64_t>(state.front[0][j]);
+        key = (key << 3) | static_cast<std::uint64_t>(state.right[0][j]);
+        key = (key << 3) | static_cast<std::uint64_t>(state.back[0][j]);
+        key = (key << 3) | static_cast<std::uint64_t>(state.left[0][j]);
+    }
+
+    return key;
+}
+
+// Lower bound for solving a pair without breaking the cross, 0 iff pair and cross are solved
+auto CfopSolver::pairBound(const PieceLocations& loc, int pair) const -> int {
+    int bound = 0;
+    for (const auto& table : m_pairTables[pair]) bound = std::max(bound, table.lookup(loc));
+    return bound;
+}
+
+// The cross table is exact, so following decreasing distances gives an optimal cross
+auto CfopSolver::solveCross(CubieCube& cube) const -> std::vector<Move> {
+    std::vector<Move> moves;
+
+    for (int d = m_crossTable->lookup(PieceLocations(cube)); d > 0; --d) {
+        for (int m = 0; m < moveCount; ++m) {
+            auto next = cube;
+            applyMove(next, static_cast<Move>(m));
+            if (m_crossTable->lookup(PieceLocations(next)) == d - 1) {
+                cube = next;
+                moves.push_back(static_cast<Move>(m));
+                break;
+            }
+        }
+    }
+
+    return moves;
+}
+
+// Depth limited search that inserts `pair` while keeping the cross and solvedPairs
+auto CfopSolver::solvePair(const CubieCube& cube, int pair, int bound, unsigned int solvedPairs, std::vector<Move>& moves) const -> bool {
+    auto loc = PieceLocations(cube);
+
+    int h = std::max(m_crossTable->lookup(loc), pairBound(loc, pair));
+    for (int p = 0; p < 4; ++p) {
+        if (solvedPairs & (1u << p)) h = std::max(h, pairBound(loc, p));
+    }
+
+    if (h == 0) return true;
+    if (static_cast<int>(moves.size()) + h > bound) return false;
+
+    int prev = moves.empty() ? -1 : static_cast<int>(moves.back());
+    int prev2 = moves.size() < 2 ? -1 : static_cast<int>(moves[moves.size() - 2]);
+
+    for (int m = 0; m < moveCount; ++m) {
+        auto move = static_cast<Move>(m);
+        if (isRedundant(move, prev, prev2)) continue;
+
+        auto next = cube;
+        applyMove(next, move);
+        moves.push_back(move);
+        if (solvePair(next, pair, bound, solvedPairs, moves)) return true;
+        moves.pop_back();
+    }
+
+    return false;
+}
+
+auto CfopSolver::buildLastLayerTables() -> void {
+    // Uniform cost search over generator combinations, keyed by the sticker pattern.
+    // A pattern reached from solved by `path` is solved by the inverse of path.
+    auto search = [](const auto& generatorNotation, auto key, auto& table) {
+        std::vector<std::vector<Move>> generators;
+        for (const auto* notation : generatorNotation) {
+            auto moves = movesFromString(notation);
+
+            auto check = solvedCubieCube();
+            for (auto move : moves) applyMove(check, move);
+            if (!keepsFirstTwoLayers(check)) throw std::runtime_error(std::string("last layer algorithm breaks F2L: ") + notation);
+
+            generators.push_back(moves);
+        }
+
+        struct Node {
+            std::size_t length;
+            CubieCube cube;
+            std::vector<Move> path;
+            auto operator>(const Node& other) const -> bool { return length > other.length; }
+        };
+
+        std::priority_queue<Node, std::vector<Node>, std::greater<Node>> open;
+        open.push(Node{ 0, solvedCubieCube(), {} });
+
+        while (!open.empty()) {
+            auto node = open.top();
+            open.pop();
+
+            auto k = key(stateFromCubie(node.cube));
+            if (table.count(k)) continue;
+            table.emplace(k, simplify(invert(node.path)));
+
+            for (const auto& generator : generators) {
+                auto next = node;
+                for (auto move : generator) applyMove(next.cube, move);
+                next.path.insert(next.path.end(), generator.begin(), generator.end());
+                next.length = next.path.size();
+                if (!table.count(key(stateFromCubie(next.cube)))) open.push(std::move(next));
+            }
+        }
+    };
+
+    search(ollGenerators, ollKey, m_oll);
+    search(pllGenerators, pllKey, m_pll);
+
+    // 27 corner twists * 8 edge flips, 4! * 4! / 2 permutations
+    if (m_oll.size() != 216 || m_pll.size() != 288) throw std::runtime_error("incomplete last layer tables!");
+}
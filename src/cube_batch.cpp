@@ -0,0 +1,230 @@
+#include "cube_batch.h"
+
+#include <array>
+#include <algorithm>
+#include <stdexcept>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+
+namespace {
+
+constexpr int edgeColumn = cornerCount;
+
+// cubes per slice in applyMoves(), 20 columns of it stay in L1
+constexpr std::size_t sliceSize = 1024;
+
+// One slot rewritten by a move: column dst takes column src, twisted or flipped by delta
+struct SlotUpdate {
+    std::uint8_t dst;
+    std::uint8_t src;
+    std::uint8_t delta;
+};
+
+struct MoveUpdate {
+    std::array<SlotUpdate, 4> corners;
+    std::array<SlotUpdate, 4> edges;
+};
+
+auto buildMoveUpdates() -> std::array<MoveUpdate, moveCount> {
+    std::array<MoveUpdate, moveCount> updates{};
+
+    for (int m = 0; m < moveCount; ++m) {
+        const auto& cube = moveCubie(static_cast<Move>(m));
+        int corners = 0;
+        int edges = 0;
+
+        for (int slot = 0; slot < cornerCount; ++slot) {
+            if (cube.cornerPerm[slot] == slot && cube.cornerOrient[slot] == 0) continue;
+            updates[m].corners.at(corners++) = { static_cast<std::uint8_t>(slot), cube.cornerPerm[slot], static_cast<std::uint8_t>(cube.cornerOrient[slot] << 3) };
+        }
+
+        for (int slot = 0; slot < edgeCount; ++slot) {
+            if (cube.edgePerm[slot] == slot && cube.edgeOrient[slot] == 0) continue;
+            updates[m].edges.at(edges++) = { static_cast<std::uint8_t>(edgeColumn + slot), static_cast<std::uint8_t>(edgeColumn + cube.edgePerm[slot]), static_cast<std::uint8_t>(cube.edgeOrient[slot] << 4) };
+        }
+
+        if (corners != 4 || edges != 4) throw std::runtime_error("quarter turn does not move 4 corners and 4 edges!");
+    }
+
+    return updates;
+}
+
+auto moveUpdates() -> const std::array<MoveUpdate, moveCount>& {
+    static const auto updates = buildMoveUpdates();
+    return updates;
+}
+
+// solved cubes have every piece in its own slot without twist or flip
+auto solvedValue(int column) -> std::uint8_t {
+    return static_cast<std::uint8_t>((column < edgeColumn) ? column : column - edgeColumn);
+}
+
+// Cubes [begin, end) of one move, begin and end are multiples of laneCount
+auto applyUpdate(std::uint8_t* data, std::size_t stride, const MoveUpdate& update, std::size_t begin, std::size_t end) -> void {
+    std::uint8_t* cornerSrc[4];
+    std::uint8_t* cornerDst[4];
+    std::uint8_t* edgeSrc[4];
+    std::uint8_t* edgeDst[4];
+
+    for (int k = 0; k < 4; ++k) {
+        cornerSrc[k] = data + update.corners[k].src * stride;
+        cornerDst[k] = data + update.corners[k].dst * stride;
+        edgeSrc[k] = data + update.edges[k].src * stride;
+        edgeDst[k] = data + update.edges[k].dst * stride;
+    }
+
+    // the 4 slots form a cycle, so all sources are read before any destination is written
+#ifdef __AVX2__
+    const auto twistRange = _mm256_set1_epi8(3 << 3);
+
+    __m256i twist[4];
+    __m256i flip[4];
+    for (int k = 0; k < 4; ++k) {
+        twist[k] = _mm256_set1_epi8(static_cast<char>(update.corners[k].delta));
+        flip[k] = _mm256_set1_epi8(static_cast<char>(update.edges[k].delta));
+    }
+
+    for (auto i = begin; i < end; i += CubeBatch::laneCount) {
+        __m256i c[4];
+        __m256i e[4];
+        for (int k = 0; k < 4; ++k) {
+            c[k] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(cornerSrc[k] + i));
+            e[k] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(edgeSrc[k] + i));
+        }
+
+        for (int k = 0; k < 4; ++k) {
+            // twist in the upper bits, wrap 3 back to 0 (values stay below 128, so signed compare is fine)
+            auto v = _mm256_add_epi8(c[k], twist[k]);
+            auto inRange = _mm256_cmpgt_epi8(twistRange, v);
+            v = _mm256_sub_epi8(v, _mm256_andnot_si256(inRange, twistRange));
+
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(cornerDst[k] + i), v);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(edgeDst[k] + i), _mm256_xor_si256(e[k], flip[k]));
+        }
+    }
+#else
+    std::uint8_t twist[4];
+    std::uint8_t flip[4];
+    for (int k = 0; k < 4; ++k) {
+        twist[k] = update.corners[k].delta;
+        flip[k] = update.edges[k].delta;
+    }
+
+    for (auto i = begin; i < end; ++i) {
+        std::uint8_t c[4];
+        std::uint8_t e[4];
+        for (int k = 0; k < 4; ++k) {
+            c[k] = cornerSrc[k][i];
+            e[k] = edgeSrc[k][i];
+        }
+
+        for (int k = 0; k < 4; ++k) {
+            auto v = static_cast<std::uint8_t>(c[k] + twist[k]);
+            if (v >= (3 << 3)) v -= (3 << 3);
+
+            cornerDst[k][i] = v;
+            edgeDst[k][i] = e[k] ^ flip[k];
+        }
+    }
+#endif
+}
+
+} // namespace
+
+
+CubeBatch::CubeBatch(std::size_t size) :
+    m_data{},
+    m_size{ 0 },
+    m_stride{ 0 }
+{
+    resize(size);
+}
+
+auto CubeBatch::resize(std::size_t size) -> void {
+    auto stride = (size + laneCount - 1) / laneCount * laneCount;
+
+    if (stride != m_stride) {
+        std::vector<std::uint8_t> data(columnCount * stride);
+
+        for (int c = 0; c < columnCount; ++c) {
+            auto dst = data.data() + c * stride;
+            auto kept = std::min(m_size, size);
+            std::copy_n(column(c), kept, dst);
+
+            std::fill(dst + kept, dst + stride, solvedValue(c));
+        }
+
+        m_data.swap(data);
+        m_stride = stride;
+    }
+    else if (size > m_size) {
+        for (int c = 0; c < columnCount; ++c) {
+            std::fill(column(c) + m_size, column(c) + size, solvedValue(c));
+        }
+    }
+
+    m_size = size;
+}
+
+auto CubeBatch::set(std::size_t index, const CubieCube& cube) -> void {
+    if (index >= m_size) throw std::runtime_error("cube batch index out of range!");
+
+    for (int slot = 0; slot < cornerCount; ++slot) {
+        column(slot)[index] = static_cast<std::uint8_t>(cube.cornerPerm[slot] | (cube.cornerOrient[slot] << 3));
+    }
+    for (int slot = 0; slot < edgeCount; ++slot) {
+        column(edgeColumn + slot)[index] = static_cast<std::uint8_t>(cube.edgePerm[slot] | (cube.edgeOrient[slot] << 4));
+    }
+}
+
+auto CubeBatch::get(std::size_t index) const -> CubieCube {
+    if (index >= m_size) throw std::runtime_error("cube batch index out of range!");
+
+    auto cube = CubieCube{};
+    for (int slot = 0; slot < cornerCount; ++slot) {
+        auto v = column(slot)[index];
+        cube.cornerPerm[slot] = v & 7;
+        cube.cornerOrient[slot] = v >> 3;
+    }
+    for (int slot = 0; slot < edgeCount; ++slot) {
+        auto v = column(edgeColumn + slot)[index];
+        cube.edgePerm[slot] = v & 15;
+        cube.edgeOrient[slot] = v >> 4;
+    }
+    return cube;
+}
+
+auto CubeBatch::isSolved(std::size_t index) const -> bool {
+    if (index >= m_size) throw std::runtime_error("cube batch index out of range!");
+
+    for (int c = 0; c < columnCount; ++c) {
+        if (column(c)[index] != solvedValue(c)) return false;
+    }
+    return true;
+}
+
+auto CubeBatch::applyMove(Move move) -> void {
+    applyUpdate(m_data.data(), m_stride, moveUpdates()[static_cast<int>(move)], 0, m_stride);
+}
+
+auto CubeBatch::applyMoves(std::span<const Move> moves) -> void {
+    for (std::size_t begin = 0; begin < m_stride; begin += sliceSize) {
+        applyMoves(moves, begin, std::min(begin + sliceSize, m_stride));
+    }
+}
+
+auto CubeBatch::applyMoves(std::span<const Move> moves, std::size_t begin, std::size_t end) -> void {
+    const auto& updates = moveUpdates();
+    for (auto move : moves) applyUpdate(m_data.data(), m_stride, updates[static_cast<int>(move)], begin, end);
+}
+
+auto CubeBatch::vectorized() -> bool {
+#ifdef __AVX2__
+    return true;
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,226 @@
+#include "cube_mesh.h"
+
+#include <cmath>
+#include <array>
+#include <algorithm>
+#include <stdexcept>
+
+#include <glad/glad.h>
+
+
+namespace {
+
+auto packSnorm16(float v) -> std::int16_t {
+    return static_cast<std::int16_t>(std::lround(std::clamp(v, -1.0f, 1.0f) * 32767.0f));
+}
+
+// colorMask bit of the face with the given outward normal, same order as RubiksCube::init()
+auto colorMaskFace(int axis, int sign) -> std::uint16_t {
+    static constexpr std::uint16_t faces[3][2] = {
+        { 2, 3 },   // x: left, right
+        { 4, 5 },   // y: bottom, top
+        { 0, 1 },   // z: back, front
+    };
+    return faces[axis][sign > 0 ? 1 : 0];
+}
+
+// Collects shared vertices and triangles, wound counter clockwise seen from outside
+class MeshBuilder {
+public:
+    auto vertex(const glm::vec3& p, std::uint16_t faceId) -> std::uint16_t {
+        auto v = CubieVertex{ { packSnorm16(p.x), packSnorm16(p.y), packSnorm16(p.z) }, faceId };
+
+        for (std::size_t i = 0; i < m_mesh.vertices.size(); ++i) {
+            const auto& w = m_mesh.vertices[i];
+            if (std::equal(std::begin(v.position), std::end(v.position), std::begin(w.position)) && v.faceId == w.faceId) {
+                return static_cast<std::uint16_t>(i);
+            }
+        }
+
+        m_mesh.vertices.push_back(v);
+        m_positions.push_back(p);
+        return static_cast<std::uint16_t>(m_mesh.vertices.size() - 1);
+    }
+
+    // provoking stays last, it decides the color of the triangle
+    auto triangle(std::uint16_t a, std::uint16_t b, std::uint16_t provoking) -> void {
+        const auto& pa = m_positions[a];
+        const auto& pb = m_positions[b];
+        const auto& pc = m_positions[provoking];
+
+        // the body is convex around its center, so outward means away from the origin
+        if (glm::dot(glm::cross(pb - pa, pc - pa), pa + pb + pc) < 0.0f) std::swap(a, b);
+
+        m_mesh.indices.push_back(a);
+        m_mesh.indices.push_back(b);
+        m_mesh.indices.push_back(provoking);
+    }
+
+    auto quad(std::uint16_t a, std::uint16_t b, std::uint16_t c, std::uint16_t d) -> void {
+        triangle(a, b, c);
+        triangle(a, c, d);
+    }
+
+    auto mesh() -> CubieMeshData { return std::move(m_mesh); }
+
+private:
+    CubieMeshData m_mesh;
+    std::vector<glm::vec3> m_positions;
+};
+
+} // namespace
+
+
+auto buildCubieMesh(const CubieMeshConfig& config) -> CubieMeshData {
+    MeshBuilder builder;
+
+    const float a = 0.5f;
+    const float inner = a - config.bevel;
+
+    const float h = inner - config.stickerMargin;
+    const float c = config.stickerCorner;
+    if (h <= c) throw std::runtime_error("cubie mesh config leaves no room for stickers!");
+
+    auto point = [](int axis0, float v0, int axis1, float v1, int axis2, float v2) {
+        auto p = glm::vec3(0.0f);
+        p[axis0] = v0;
+        p[axis1] = v1;
+        p[axis2] = v2;
+        return p;
+    };
+
+    // corner of the flat part of the face of axis n, shared with the chamfers
+    auto bodyCorner = [&](int n, int s, float pu, float pv) {
+        return builder.vertex(point(n, s * a, (n + 1) % 3, pu, (n + 2) % 3, pv), bodyFaceId);
+    };
+
+    // octagon starting at the side of square corner 0 towards corner 1, the corners are
+    // cut between octagon points 2k - 1 and 2k
+    const std::array<std::array<float, 2>, 8> octagon = { {
+        { -h + c, -h }, { h - c, -h }, { h, -h + c }, { h, h - c },
+        { h - c, h }, { -h + c, h }, { -h, h - c }, { -h, -h + c },
+    } };
+    const std::array<std::array<float, 2>, 4> square = { {
+        { -inner, -inner }, { inner, -inner }, { inner, inner }, { -inner, inner },
+    } };
+
+    // flat faces: sticker fan and the body ring around it
+    for (int n = 0; n < 3; ++n) {
+        int u = (n + 1) % 3;
+        int v = (n + 2) % 3;
+        for (int s = -1; s <= 1; s += 2) {
+            std::array<std::uint16_t, 8> o;
+            std::array<std::uint16_t, 4> q;
+            for (int i = 0; i < 8; ++i) o[i] = builder.vertex(point(n, s * a, u, octagon[i][0], v, octagon[i][1]), colorMaskFace(n, s));
+            for (int k = 0; k < 4; ++k) q[k] = bodyCorner(n, s, square[k][0], square[k][1]);
+
+            for (int i = 1; i + 1 < 8; ++i) builder.triangle(o[0], o[i], o[i + 1]);
+
+            for (int k = 0; k < 4; ++k) {
+                int next = (k + 1) % 4;
+                builder.triangle(o[(2 * k + 7) % 8], o[2 * k], q[k]);       // cut corner
+                builder.triangle(o[2 * k], q[k], q[next]);                  // side, split along q[next] - o[2k]
+                builder.triangle(o[2 * k], o[2 * k + 1], q[next]);
+            }
+        }
+    }
+
+    // edge chamfers between the faces of axis i and j, running along k
+    for (int i = 0; i < 3; ++i) {
+        for (int j = i + 1; j < 3; ++j) {
+            int k = 3 - i - j;
+            for (int si = -1; si <= 1; si += 2) {
+                for (int sj = -1; sj <= 1; sj += 2) {
+                    builder.quad(
+                        builder.vertex(point(i, si * a, j, sj * inner, k, -inner), bodyFaceId),
+                        builder.vertex(point(i, si * a, j, sj * inner, k, inner), bodyFaceId),
+                        builder.vertex(point(i, si * inner, j, sj * a, k, inner), bodyFaceId),
+                        builder.vertex(point(i, si * inner, j, sj * a, k, -inner), bodyFaceId));
+                }
+            }
+        }
+    }
+
+    // corner triangles
+    for (int sx = -1; sx <= 1; sx += 2) {
+        for (int sy = -1; sy <= 1; sy += 2) {
+            for (int sz = -1; sz <= 1; sz += 2) {
+                builder.triangle(
+                    builder.vertex(glm::vec3(sx * a, sy * inner, sz * inner), bodyFaceId),
+                    builder.vertex(glm::vec3(sx * inner, sy * a, sz * inner), bodyFaceId),
+                    builder.vertex(glm::vec3(sx * inner, sy * inner, sz * a), bodyFaceId));
+            }
+        }
+    }
+
+    return builder.mesh();
+}
+
+CubeMesh::CubeMesh(const CubieMeshConfig& config) :
+    m_vao{ 0 },
+    m_vertexBuffer{ 0 },
+    m_indexBuffer{ 0 },
+    m_instanceBuffer{ 0 },
+    m_vertexCount{ 0 },
+    m_indexCount{ 0 },
+    m_instanceCapacity{ 0 }
+{
+    auto mesh = buildCubieMesh(config);
+    m_vertexCount = mesh.vertices.size();
+    m_indexCount = mesh.indices.size();
+
+    glGenVertexArrays(1, &m_vao);
+    glGenBuffers(1, &m_vertexBuffer);
+    glGenBuffers(1, &m_indexBuffer);
+    glGenBuffers(1, &m_instanceBuffer);
+
+    glBindVertexArray(m_vao);
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, mesh.vertices.size() * sizeof(CubieVertex), mesh.vertices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.indices.size() * sizeof(std::uint16_t), mesh.indices.data(), GL_STATIC_DRAW);
+
+    // per vertex: position, face id
+    glVertexAttribPointer(0, 3, GL_SHORT, GL_TRUE, sizeof(CubieVertex), (void*)offsetof(CubieVertex, position));
+    glEnableVertexAttribArray(0);
+    glVertexAttribIPointer(1, 1, GL_UNSIGNED_SHORT, sizeof(CubieVertex), (void*)offsetof(CubieVertex, faceId));
+    glEnableVertexAttribArray(1);
+
+    // per instance: model matrix columns and colorMask
+    glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+    for (int column = 0; column < 4; ++column) {
+        glVertexAttribPointer(3 + column, 4, GL_FLOAT, GL_FALSE, sizeof(CubieInstance), (void*)(offsetof(CubieInstance, model) + column * sizeof(glm::vec4)));
+        glEnableVertexAttribArray(3 + column);
+        glVertexAttribDivisor(3 + column, 1);
+    }
+    glVertexAttribIPointer(7, 1, GL_UNSIGNED_INT, sizeof(CubieInstance), (void*)offsetof(CubieInstance, colorMask));
+    glEnableVertexAttribArray(7);
+    glVertexAttribDivisor(7, 1);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+auto CubeMesh::draw(const std::vector<CubieInstance>& instances) -> void {
+    if (instances.empty()) return;
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+    if (instances.size() > m_instanceCapacity) {
+        m_instanceCapacity = std::max(instances.size(), m_instanceCapacity * 2);
+        glBufferData(GL_ARRAY_BUFFER, m_instanceCapacity * sizeof(CubieInstance), nullptr, GL_DYNAMIC_DRAW);
+    }
+    glBufferSubData(GL_ARRAY_BUFFER, 0, instances.size() * sizeof(CubieInstance), instances.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glBindVertexArray(m_vao);
+    glDrawElementsInstanced(GL_TRIANGLES, static_cast<GLsizei>(m_indexCount), GL_UNSIGNED_SHORT, nullptr, static_cast<GLsizei>(instances.size()));
+    glBindVertexArray(0);
+}
+
+auto CubeMesh::destroy() -> void {
+    glDeleteVertexArrays(1, &m_vao);
+    glDeleteBuffers(1, &m_vertexBuffer);
+    glDeleteBuffers(1, &m_indexBuffer);
+    glDeleteBuffers(1, &m_instanceBuffer);
+}
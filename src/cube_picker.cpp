@@ -0,0 +1,108 @@
+#include "cube_picker.h"
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+
+namespace {
+
+auto halfSize(float cubeSpacing) -> float {
+    return cubeSpacing + 0.5f;
+}
+
+auto gridCell(float coord, float cubeSpacing) -> int {
+    return std::clamp(static_cast<int>(std::lround(coord / cubeSpacing)), -1, 1);
+}
+
+auto unitAxis(int axis) -> glm::vec3 {
+    auto v = glm::vec3(0.0f);
+    v[axis] = 1.0f;
+    return v;
+}
+
+} // namespace
+
+
+auto cursorRay(double x, double y, int width, int height, const glm::mat4& projection, const glm::mat4& view) -> Ray {
+    auto ndcX = static_cast<float>(2.0 * x / width - 1.0);
+    auto ndcY = static_cast<float>(1.0 - 2.0 * y / height);
+
+    auto inverse = glm::inverse(projection * view);
+    auto nearPoint = inverse * glm::vec4(ndcX, ndcY, -1.0f, 1.0f);
+    auto farPoint = inverse * glm::vec4(ndcX, ndcY, 1.0f, 1.0f);
+
+    auto origin = glm::vec3(nearPoint) / nearPoint.w;
+    auto target = glm::vec3(farPoint) / farPoint.w;
+    return Ray{ origin, glm::normalize(target - origin) };
+}
+
+auto pickFacelet(const Ray& ray, float cubeSpacing) -> std::optional<FaceletHit> {
+    auto h = halfSize(cubeSpacing);
+
+    // slab test, the axis of the latest entry is the face that was hit
+    float tNear = -std::numeric_limits<float>::infinity();
+    float tFar = std::numeric_limits<float>::infinity();
+    int axis = -1;
+
+    for (int a = 0; a < 3; ++a) {
+        if (std::abs(ray.direction[a]) < 1e-8f) {
+            if (std::abs(ray.origin[a]) > h) return std::nullopt;
+            continue;
+        }
+
+        auto t0 = (-h - ray.origin[a]) / ray.direction[a];
+        auto t1 = (h - ray.origin[a]) / ray.direction[a];
+        if (t0 > t1) std::swap(t0, t1);
+
+        if (t0 > tNear) {
+            tNear = t0;
+            axis = a;
+        }
+        tFar = std::min(tFar, t1);
+    }
+
+    // missed, or the camera is inside the cube
+    if (axis < 0 || tNear > tFar || tNear < 0.0f) return std::nullopt;
+
+    auto hit = FaceletHit{};
+    hit.point = ray.origin + ray.direction * tNear;
+    hit.normalAxis = axis;
+    hit.normalSign = (ray.direction[axis] < 0.0f) ? 1 : -1;
+
+    for (int a = 0; a < 3; ++a) {
+        hit.cell[a] = (a == axis) ? hit.normalSign : gridCell(hit.point[a], cubeSpacing);
+    }
+
+    return hit;
+}
+
+auto dragTurn(const FaceletHit& grab, const Ray& ray, float cubeSpacing, float threshold) -> std::optional<MoveAxis> {
+    auto n = grab.normalAxis;
+    auto planeOffset = grab.normalSign * halfSize(cubeSpacing);
+
+    // drag point on the plane of the grabbed face
+    if (std::abs(ray.direction[n]) < 1e-8f) return std::nullopt;
+    auto t = (planeOffset - ray.origin[n]) / ray.direction[n];
+    if (t < 0.0f) return std::nullopt;
+
+    auto drag = ray.origin + ray.direction * t - grab.point;
+
+    // dominant in plane direction of the drag
+    auto a = (n + 1) % 3;
+    auto b = (n + 2) % 3;
+    auto dragAxis = (std::abs(drag[a]) >= std::abs(drag[b])) ? a : b;
+    if (std::abs(drag[dragAxis]) < threshold) return std::nullopt;
+
+    // the layer turns about the axis perpendicular to the face normal and the drag
+    auto turnAxis = 3 - n - dragAxis;
+    auto layer = grab.cell[turnAxis];
+    if (layer == 0) return std::nullopt;
+
+    // positive rotation about +turnAxis moves the grabbed point along turnAxis x point
+    auto velocity = glm::cross(unitAxis(turnAxis), grab.point);
+    bool positive = (velocity[dragAxis] > 0.0f) == (drag[dragAxis] > 0.0f);
+
+    // RubiksCube turns by side * direction quarter turns about +axis
+    return MoveAxis{ .axis = turnAxis, .side = layer, .direction = positive ? layer : -layer };
+}
@@ -0,0 +1,272 @@
+#include "cube_state.h"
+
+#include <array>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+
+namespace {
+
+struct Int3 {
+    int v[3];
+};
+
+struct Facelet {
+    Int3 pos;
+    Int3 normal;
+};
+
+// Same grid mapping as RubiksCube::recomputeCubeState()
+auto faceletToGeometry(int index) -> Facelet {
+    int face = index / 9;
+    int row = (index % 9) / 3;
+    int col = index % 3;
+
+    switch (face) {
+    case 0: return { { col - 1, 1 - row, 1 }, { 0, 0, 1 } };    // front
+    case 1: return { { 1 - col, 1 - row, -1 }, { 0, 0, -1 } };  // back
+    case 2: return { { -1, 1 - row, col - 1 }, { -1, 0, 0 } };  // left
+    case 3: return { { 1, 1 - row, 1 - col }, { 1, 0, 0 } };    // right
+    case 4: return { { col - 1, 1, row - 1 }, { 0, 1, 0 } };    // top
+    default: return { { col - 1, -1, 1 - row }, { 0, -1, 0 } }; // bottom
+    }
+}
+
+auto geometryToFacelet(const Facelet& f) -> int {
+    int x = f.pos.v[0];
+    int y = f.pos.v[1];
+    int z = f.pos.v[2];
+
+    if (f.normal.v[2] == 1) return 0 * 9 + (1 - y) * 3 + (x + 1);
+    if (f.normal.v[2] == -1) return 1 * 9 + (1 - y) * 3 + (1 - x);
+    if (f.normal.v[0] == -1) return 2 * 9 + (1 - y) * 3 + (z + 1);
+    if (f.normal.v[0] == 1) return 3 * 9 + (1 - y) * 3 + (1 - z);
+    if (f.normal.v[1] == 1) return 4 * 9 + (z + 1) * 3 + (x + 1);
+    return 5 * 9 + (1 - z) * 3 + (x + 1);
+}
+
+// Quarter turn about a positive coordinate axis, quarterTurns is +1 or -1
+auto rotate(Int3 p, int axis, int quarterTurns) -> Int3 {
+    int a = (axis + 1) % 3;
+    int b = (axis + 2) % 3;
+
+    auto r = p;
+    r.v[a] = -quarterTurns * p.v[b];
+    r.v[b] = quarterTurns * p.v[a];
+    return r;
+}
+
+// gather[move][dst] = src facelet index
+using MoveTable = std::array<std::array<std::uint8_t, faceletCount>, moveCount>;
+
+auto buildMoveTable() -> MoveTable {
+    MoveTable table{};
+
+    for (int m = 0; m < moveCount; ++m) {
+        auto cfg = moveToAxis(static_cast<Move>(m));
+        // glm::rotate(direction * 90, axis * side) is a turn of side * direction about +axis
+        int quarterTurns = cfg.side * cfg.direction;
+
+        for (int src = 0; src < faceletCount; ++src) {
+            auto f = faceletToGeometry(src);
+            int dst = src;
+
+            if (f.pos.v[cfg.axis] == cfg.side) {
+                dst = geometryToFacelet({
+                    rotate(f.pos, cfg.axis, quarterTurns),
+                    rotate(f.normal, cfg.axis, quarterTurns)
+                });
+            }
+            table[m][dst] = static_cast<std::uint8_t>(src);
+        }
+    }
+
+    return table;
+}
+
+auto moveTable() -> const MoveTable& {
+    static const MoveTable table = buildMoveTable();
+    return table;
+}
+
+} // namespace
+
+
+auto colorToString(Color c) -> std::string {
+    switch (c) {
+    case Color::BLUE: return "B";
+    case Color::GREEN: return "G";
+    case Color::ORANGE: return "O";
+    case Color::RED: return "R";
+    case Color::YELLOW: return "Y";
+    case Color::WHITE: return "W";
+    case Color::BLACK: return "X";
+    default: return "?";
+    }
+}
+
+auto moveToAxis(Move move) -> MoveAxis {
+    // axis, side of the plain turn
+    static constexpr int faces[6][2] = {
+        { 2, 1 },   // front
+        { 2, -1 },  // back
+        { 0, -1 },  // left
+        { 0, 1 },   // right
+        { 1, 1 },   // up
+        { 1, -1 },  // down
+    };
+
+    auto m = static_cast<int>(move);
+    return MoveAxis{
+        .axis = faces[m / 2][0],
+        .side = faces[m / 2][1],
+        .direction = (m % 2 == 0) ? -1 : 1
+    };
+}
+
+auto moveFromAxis(int axis, int side, int direction) -> Move {
+    int face = 0;
+    if (axis == 2) face = (side == 1) ? 0 : 1;
+    else if (axis == 0) face = (side == -1) ? 2 : 3;
+    else face = (side == 1) ? 4 : 5;
+
+    return static_cast<Move>(face * 2 + ((direction == -1) ? 0 : 1));
+}
+
+auto inverseMove(Move move) -> Move {
+    return static_cast<Move>(static_cast<int>(move) ^ 1);
+}
+
+auto moveToString(Move move) -> std::string {
+    static constexpr const char* names[moveCount] = {
+        "F", "F'", "B", "B'", "L", "L'", "R", "R'", "U", "U'", "D", "D'"
+    };
+    return names[static_cast<int>(move)];
+}
+
+auto movesFromString(const std::string& notation) -> std::vector<Move> {
+    static constexpr char faces[] = "FBLRUD";
+
+    std::vector<Move> moves;
+    std::istringstream in{ notation };
+    std::string token;
+
+    while (in >> token) {
+        auto face = std::string(faces).find(token[0]);
+        if (face == std::string::npos || token.size() > 3) throw std::runtime_error("unknown move: " + token);
+
+        auto suffix = token.substr(1);
+        auto move = static_cast<Move>(face * 2);
+        if (suffix.empty()) moves.push_back(move);
+        else if (suffix == "'") moves.push_back(inverseMove(move));
+        else if (suffix == "2" || suffix == "2'") moves.insert(moves.end(), 2, move);
+        else throw std::runtime_error("unknown move: " + token);
+    }
+
+    return moves;
+}
+
+auto movesToString(const std::vector<Move>& moves) -> std::string {
+    std::string result;
+
+    for (std::size_t i = 0; i < moves.size(); ++i) {
+        if (!result.empty()) result += " ";
+
+        // print repeated quarter turns as half turns
+        if (i + 1 < moves.size() && moves[i + 1] == moves[i]) {
+            result += moveToString(moves[i]).substr(0, 1) + "2";
+            ++i;
+        }
+        else {
+            result += moveToString(moves[i]);
+        }
+    }
+
+    return result;
+}
+
+auto solvedCubeState() -> CubeState {
+    CubeState state;
+
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            state.front[i][j] = Color::GREEN;
+            state.back[i][j] = Color::BLUE;
+            state.left[i][j] = Color::ORANGE;
+            state.right[i][j] = Color::RED;
+            state.top[i][j] = Color::WHITE;
+            state.bottom[i][j] = Color::YELLOW;
+        }
+    }
+
+    return state;
+}
+
+auto faceletIndex(int x, int y, int z, int normalAxis, int normalSign) -> int {
+    auto f = Facelet{ { x, y, z }, { 0, 0, 0 } };
+    f.normal.v[normalAxis] = normalSign;
+    return geometryToFacelet(f);
+}
+
+auto faceletColor(const CubeState& state, int index) -> Color {
+    int row = (index % 9) / 3;
+    int col = index % 3;
+
+    switch (index / 9) {
+    case 0: return state.front[row][col];
+    case 1: return state.back[row][col];
+    case 2: return state.left[row][col];
+    case 3: return state.right[row][col];
+    case 4: return state.top[row][col];
+    default: return state.bottom[row][col];
+    }
+}
+
+auto applyMove(CubeState& state, Move move) -> void {
+    static_assert(sizeof(CubeState) == faceletCount * sizeof(Color));
+
+    const auto& gather = moveTable()[static_cast<int>(move)];
+
+    Color src[faceletCount];
+    Color dst[faceletCount];
+    std::memcpy(src, &state, sizeof(CubeState));
+
+    for (int i = 0; i < faceletCount; ++i) {
+        dst[i] = src[gather[i]];
+    }
+
+    std::memcpy(&state, dst, sizeof(CubeState));
+}
+
+auto isSolved(const CubeState& state) -> bool {
+    static const CubeState solved = solvedCubeState();
+    return state == solved;
+}
+
+auto operator==(const CubeState& a, const CubeState& b) -> bool {
+    return std::memcmp(&a, &b, sizeof(CubeState)) == 0;
+}
+
+auto stateToString(const CubeState& state) -> std::string {
+    std::string text;
+    for (int i = 0; i < faceletCount; ++i) text += colorToString(faceletColor(state, i));
+    return text;
+}
+
+auto stateFromString(const std::string& text) -> CubeState {
+    static constexpr char letters[] = "BGORYWX";
+
+    if (text.size() != faceletCount) throw std::runtime_error("cube state needs 54 facelets: " + text);
+
+    Color facelets[faceletCount];
+    for (int i = 0; i < faceletCount; ++i) {
+        auto color = std::string(letters).find(text[i]);
+        if (color == std::string::npos) throw std::runtime_error("unknown facelet color: " + text.substr(i, 1));
+        facelets[i] = static_cast<Color>(color);
+    }
+
+    CubeState state;
+    std::memcpy(&state, facelets, sizeof(CubeState));
+    return state;
+}
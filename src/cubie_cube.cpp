@@ -0,0 +1,359 @@
+#include "cubie_cube.h"
+
+#include <cstring>
+#include <stdexcept>
+
+
+namespace {
+
+constexpr int cornerPositions[cornerCount][3] = {
+    { 1, 1, 1 }, { -1, 1, 1 }, { -1, 1, -1 }, { 1, 1, -1 },
+    { 1, -1, 1 }, { -1, -1, 1 }, { -1, -1, -1 }, { 1, -1, -1 },
+};
+
+constexpr int edgePositions[edgeCount][3] = {
+    { 1, 1, 0 }, { 0, 1, 1 }, { -1, 1, 0 }, { 0, 1, -1 },
+    { 1, -1, 0 }, { 0, -1, 1 }, { -1, -1, 0 }, { 0, -1, -1 },
+    { 1, 0, 1 }, { -1, 0, 1 }, { -1, 0, -1 }, { 1, 0, -1 },
+};
+
+struct Tables {
+    std::array<std::array<int, 3>, cornerCount> cornerFacelets;
+    std::array<std::array<int, 2>, edgeCount> edgeFacelets;
+    std::array<std::array<Color, 3>, cornerCount> cornerColors;
+    std::array<std::array<Color, 2>, edgeCount> edgeColors;
+    std::array<CubieCube, moveCount> moves;
+};
+
+auto buildTables() -> Tables;
+
+auto tables() -> const Tables& {
+    static const Tables t = buildTables();
+    return t;
+}
+
+auto isUpDown(Color c) -> bool {
+    return c == Color::WHITE || c == Color::YELLOW;
+}
+
+// true if perm holds every piece id below N exactly once
+template <std::size_t N>
+auto isPermutation(const std::array<std::uint8_t, N>& perm) -> bool {
+    std::array<bool, N> seen{};
+    for (auto piece : perm) {
+        if (piece >= N || seen[piece]) return false;
+        seen[piece] = true;
+    }
+    return true;
+}
+
+auto readCubie(const Tables& t, const CubeState& state) -> CubieCube {
+    auto cube = CubieCube{};
+
+    for (int slot = 0; slot < cornerCount; ++slot) {
+        Color c[3];
+        for (int k = 0; k < 3; ++k) c[k] = faceletColor(state, t.cornerFacelets[slot][k]);
+
+        int twist = 0;
+        while (twist < 3 && !isUpDown(c[twist])) ++twist;
+        if (twist == 3) throw std::runtime_error("corner without U/D sticker!");
+
+        int piece = 0;
+        while (piece < cornerCount) {
+            const auto& pc = t.cornerColors[piece];
+            if (pc[0] == c[twist] && pc[1] == c[(twist + 1) % 3] && pc[2] == c[(twist + 2) % 3]) break;
+            ++piece;
+        }
+        if (piece == cornerCount) throw std::runtime_error("unknown corner piece!");
+
+        cube.cornerPerm[slot] = static_cast<std::uint8_t>(piece);
+        cube.cornerOrient[slot] = static_cast<std::uint8_t>(twist);
+    }
+
+    for (int slot = 0; slot < edgeCount; ++slot) {
+        auto c0 = faceletColor(state, t.edgeFacelets[slot][0]);
+        auto c1 = faceletColor(state, t.edgeFacelets[slot][1]);
+
+        int piece = 0;
+        int flip = 0;
+        while (piece < edgeCount) {
+            const auto& pc = t.edgeColors[piece];
+            if (pc[0] == c0 && pc[1] == c1) { flip = 0; break; }
+            if (pc[0] == c1 && pc[1] == c0) { flip = 1; break; }
+            ++piece;
+        }
+        if (piece == edgeCount) throw std::runtime_error("unknown edge piece!");
+
+        cube.edgePerm[slot] = static_cast<std::uint8_t>(piece);
+        cube.edgeOrient[slot] = static_cast<std::uint8_t>(flip);
+    }
+
+    // every slot matched some piece, but the stickers may show a piece twice and another not at all
+    if (!isPermutation(cube.cornerPerm)) throw std::runtime_error("duplicated corner piece!");
+    if (!isPermutation(cube.edgePerm)) throw std::runtime_error("duplicated edge piece!");
+
+    return cube;
+}
+
+auto buildTables() -> Tables {
+    auto t = Tables{};
+
+    for (int slot = 0; slot < cornerCount; ++slot) {
+        const auto& p = cornerPositions[slot];
+        int up = faceletIndex(p[0], p[1], p[2], 1, p[1]);
+        int x = faceletIndex(p[0], p[1], p[2], 0, p[0]);
+        int z = faceletIndex(p[0], p[1], p[2], 2, p[2]);
+
+        // (n_y, n_x, n_z) is clockwise seen from outside iff (n_y x n_x) . n_z < 0,
+        // (0, y, 0) x (x, 0, 0) = (0, 0, -x * y)
+        bool clockwise = -p[0] * p[1] * p[2] < 0;
+        t.cornerFacelets[slot] = clockwise ? std::array<int, 3>{ up, x, z } : std::array<int, 3>{ up, z, x };
+    }
+
+    for (int slot = 0; slot < edgeCount; ++slot) {
+        const auto& p = edgePositions[slot];
+        if (p[1] != 0) {
+            int other = (p[0] != 0) ? 0 : 2;
+            t.edgeFacelets[slot] = { faceletIndex(p[0], p[1], p[2], 1, p[1]), faceletIndex(p[0], p[1], p[2], other, p[other]) };
+        }
+        else {
+            t.edgeFacelets[slot] = { faceletIndex(p[0], p[1], p[2], 2, p[2]), faceletIndex(p[0], p[1], p[2], 0, p[0]) };
+        }
+    }
+
+    auto solved = solvedCubeState();
+    for (int slot = 0; slot < cornerCount; ++slot) {
+        for (int k = 0; k < 3; ++k) t.cornerColors[slot][k] = faceletColor(solved, t.cornerFacelets[slot][k]);
+    }
+    for (int slot = 0; slot < edgeCount; ++slot) {
+        for (int k = 0; k < 2; ++k) t.edgeColors[slot][k] = faceletColor(solved, t.edgeFacelets[slot][k]);
+    }
+
+    // each move as the cubie cube it produces from solved
+    for (int m = 0; m < moveCount; ++m) {
+        auto state = solved;
+        ::applyMove(state, static_cast<Move>(m));
+        t.moves[m] = readCubie(t, state);
+    }
+
+    return t;
+}
+
+// Lehmer code of a permutation
+template <std::size_t N>
+auto permutationRank(const std::array<std::uint8_t, N>& perm) -> int {
+    int coord = 0;
+    for (std::size_t i = 0; i < N; ++i) {
+        int smaller = 0;
+        for (std::size_t j = i + 1; j < N; ++j) {
+            if (perm[j] < perm[i]) ++smaller;
+        }
+        coord = coord * static_cast<int>(N - i) + smaller;
+    }
+    return coord;
+}
+
+template <std::size_t N>
+auto permutationUnrank(std::array<std::uint8_t, N>& perm, int coord) -> void {
+    int digits[N];
+    for (std::size_t i = N; i-- > 0;) {
+        digits[i] = coord % static_cast<int>(N - i);
+        coord /= static_cast<int>(N - i);
+    }
+
+    bool used[N] = {};
+    for (std::size_t i = 0; i < N; ++i) {
+        int k = digits[i];
+        std::size_t piece = 0;
+        while (used[piece] || k > 0) {
+            if (!used[piece]) --k;
+            ++piece;
+        }
+        used[piece] = true;
+        perm[i] = static_cast<std::uint8_t>(piece);
+    }
+}
+
+template <std::size_t N>
+auto permutationParity(const std::array<std::uint8_t, N>& perm) -> int {
+    int parity = 0;
+    for (std::size_t i = 0; i < N; ++i) {
+        for (std::size_t j = i + 1; j < N; ++j) {
+            if (perm[i] > perm[j]) parity ^= 1;
+        }
+    }
+    return parity;
+}
+
+} // namespace
+
+
+auto solvedCubieCube() -> CubieCube {
+    auto cube = CubieCube{};
+    for (int i = 0; i < cornerCount; ++i) cube.cornerPerm[i] = static_cast<std::uint8_t>(i);
+    for (int i = 0; i < edgeCount; ++i) cube.edgePerm[i] = static_cast<std::uint8_t>(i);
+    return cube;
+}
+
+auto cubieFromState(const CubeState& state) -> CubieCube {
+    return readCubie(tables(), state);
+}
+
+auto stateFromCubie(const CubieCube& cube) -> CubeState {
+    const auto& t = tables();
+
+    // centers never move
+    auto state = solvedCubeState();
+    Color facelets[faceletCount];
+    static_assert(sizeof(CubeState) == sizeof(facelets));
+    std::memcpy(facelets, &state, sizeof(CubeState));
+
+    for (int slot = 0; slot < cornerCount; ++slot) {
+        const auto& pc = t.cornerColors[cube.cornerPerm[slot]];
+        for (int k = 0; k < 3; ++k) {
+            facelets[t.cornerFacelets[slot][(k + cube.cornerOrient[slot]) % 3]] = pc[k];
+        }
+    }
+
+    for (int slot = 0; slot < edgeCount; ++slot) {
+        const auto& pc = t.edgeColors[cube.edgePerm[slot]];
+        for (int k = 0; k < 2; ++k) {
+            facelets[t.edgeFacelets[slot][(k + cube.edgeOrient[slot]) % 2]] = pc[k];
+        }
+    }
+
+    std::memcpy(&state, facelets, sizeof(CubeState));
+    return state;
+}
+
+auto applyMove(CubieCube& cube, Move move) -> void {
+    const auto& m = tables().moves[static_cast<int>(move)];
+    auto src = cube;
+
+    for (int i = 0; i < cornerCount; ++i) {
+        auto from = m.cornerPerm[i];
+        cube.cornerPerm[i] = src.cornerPerm[from];
+        cube.cornerOrient[i] = static_cast<std::uint8_t>((src.cornerOrient[from] + m.cornerOrient[i]) % 3);
+    }
+
+    for (int i = 0; i < edgeCount; ++i) {
+        auto from = m.edgePerm[i];
+        cube.edgePerm[i] = src.edgePerm[from];
+        cube.edgeOrient[i] = src.edgeOrient[from] ^ m.edgeOrient[i];
+    }
+}
+
+auto isSolvable(const CubieCube& cube) -> bool {
+    if (!isPermutation(cube.cornerPerm) || !isPermutation(cube.edgePerm)) return false;
+
+    int twist = 0;
+    int flip = 0;
+    for (auto t : cube.cornerOrient) {
+        if (t > 2) return false;
+        twist += t;
+    }
+    for (auto f : cube.edgeOrient) {
+        if (f > 1) return false;
+        flip += f;
+    }
+
+    return twist % 3 == 0 && flip % 2 == 0 && permutationParity(cube.cornerPerm) == permutationParity(cube.edgePerm);
+}
+
+auto moveCubie(Move move) -> const CubieCube& {
+    return tables().moves[static_cast<int>(move)];
+}
+
+auto cornerOrientCoord(const CubieCube& cube) -> int {
+    int coord = 0;
+    for (int i = 0; i < cornerCount - 1; ++i) coord = coord * 3 + cube.cornerOrient[i];
+    return coord;
+}
+
+auto edgeOrientCoord(const CubieCube& cube) -> int {
+    int coord = 0;
+    for (int i = 0; i < edgeCount - 1; ++i) coord = coord * 2 + cube.edgeOrient[i];
+    return coord;
+}
+
+auto cornerPermCoord(const CubieCube& cube) -> int {
+    return permutationRank(cube.cornerPerm);
+}
+
+auto edgePermCoord(const CubieCube& cube) -> int {
+    return permutationRank(cube.edgePerm);
+}
+
+auto setCornerOrientCoord(CubieCube& cube, int coord) -> void {
+    int sum = 0;
+    for (int i = cornerCount - 2; i >= 0; --i) {
+        cube.cornerOrient[i] = static_cast<std::uint8_t>(coord % 3);
+        sum += coord % 3;
+        coord /= 3;
+    }
+    cube.cornerOrient[cornerCount - 1] = static_cast<std::uint8_t>((3 - sum % 3) % 3);
+}
+
+auto setEdgeOrientCoord(CubieCube& cube, int coord) -> void {
+    int sum = 0;
+    for (int i = edgeCount - 2; i >= 0; --i) {
+        cube.edgeOrient[i] = static_cast<std::uint8_t>(coord % 2);
+        sum += coord % 2;
+        coord /= 2;
+    }
+    cube.edgeOrient[edgeCount - 1] = static_cast<std::uint8_t>(sum % 2);
+}
+
+auto setCornerPermCoord(CubieCube& cube, int coord) -> void {
+    permutationUnrank(cube.cornerPerm, coord);
+}
+
+auto setEdgePermCoord(CubieCube& cube, int coord) -> void {
+    permutationUnrank(cube.edgePerm, coord);
+}
+
+auto cubieKey(const CubieCube& cube) -> CubieKey {
+    return CubieKey{
+        .corners = static_cast<std::uint64_t>(cornerPermCoord(cube)) * cornerOrientCoordCount + cornerOrientCoord(cube),
+        .edges = static_cast<std::uint64_t>(edgePermCoord(cube)) * edgeOrientCoordCount + edgeOrientCoord(cube)
+    };
+}
+
+auto cubieFromKey(const CubieKey& key) -> CubieCube {
+    auto cube = CubieCube{};
+    setCornerPermCoord(cube, static_cast<int>(key.corners / cornerOrientCoordCount));
+    setCornerOrientCoord(cube, static_cast<int>(key.corners % cornerOrientCoordCount));
+    setEdgePermCoord(cube, static_cast<int>(key.edges / edgeOrientCoordCount));
+    setEdgeOrientCoord(cube, static_cast<int>(key.edges % edgeOrientCoordCount));
+    return cube;
+}
+
+auto cornerFacelets(int slot) -> const std::array<int, 3>& {
+    return tables().cornerFacelets[slot];
+}
+
+auto edgeFacelets(int slot) -> const std::array<int, 2>& {
+    return tables().edgeFacelets[slot];
+}
+
+auto packState(const CubieCube& cube) -> PackedState {
+    auto key = cubieKey(cube);
+    auto low = key.corners | (key.edges << 27);
+    auto high = key.edges >> 37;
+
+    auto packed = PackedState{};
+    for (int i = 0; i < 8; ++i) packed[i] = static_cast<std::uint8_t>(low >> (8 * i));
+    packed[8] = static_cast<std::uint8_t>(high);
+    return packed;
+}
+
+auto unpackState(const PackedState& packed) -> CubieCube {
+    std::uint64_t low = 0;
+    for (int i = 0; i < 8; ++i) low |= static_cast<std::uint64_t>(packed[i]) << (8 * i);
+    std::uint64_t high = packed[8];
+
+    return cubieFromKey(CubieKey{
+        .corners = low & ((std::uint64_t(1) << 27) - 1),
+        .edges = (low >> 27) | (high << 37)
+    });
+}
@@ -0,0 +1,264 @@
+#include "korf_solver.h"
+
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <limits>
+#include <string>
+#include <algorithm>
+#include <condition_variable>
+
+#include "profiler.h"
+
+
+namespace {
+
+constexpr int noMove = 15;
+
+// subtrees below the first 3 moves (1068 canonical sequences) are the unit of work
+constexpr int splitDepth = 3;
+
+// nodes counted locally before they are added to the shared counter
+constexpr std::uint64_t nodeFlushInterval = std::uint64_t(1) << 14;
+
+// Canonical sequences only: no undo, a face twice only as a plain half turn and never
+// three times, and opposite faces, which commute, only in one order
+auto allowedAfter(int move, int last, int beforeLast) -> bool {
+    if (last == noMove) return true;
+    if (move == (last ^ 1)) return false;
+    if (move == last) return (move & 1) == 0 && move != beforeLast;
+    if ((move >> 2) == (last >> 2) && move < last) return false;
+    return true;
+}
+
+auto lowerTo(std::atomic<int>& value, int candidate) -> void {
+    auto current = value.load(std::memory_order_relaxed);
+    while (candidate < current && !value.compare_exchange_weak(current, candidate, std::memory_order_relaxed)) {}
+}
+
+struct Subtree {
+    PieceCube cube;
+    std::vector<Move> path;
+    int last;
+    int beforeLast;
+};
+
+// Shared by all workers of one iteration
+struct Iteration {
+    int bound = 0;
+    int rootParity = 0;
+    std::atomic<int> nextBound{ std::numeric_limits<int>::max() };
+    std::atomic<bool> found{ false };
+    std::atomic<std::uint64_t> nodes{ 0 };
+
+    std::mutex solutionMutex;
+    std::vector<Move> solution;
+};
+
+class Searcher {
+public:
+    Searcher(const KorfSolver& solver, Iteration& iteration) :
+        m_solver{ solver },
+        m_iteration{ iteration },
+        m_nodes{ 0 },
+        m_path{}
+    {
+    }
+
+    ~Searcher() { m_iteration.nodes += m_nodes; }
+
+    Searcher(const Searcher&) = delete;
+    auto operator=(const Searcher&) -> Searcher& = delete;
+
+    // Depth first search below cube with the iteration bound, true if it found the solution
+    auto search(const PieceCube& cube, int g, int last, int beforeLast) -> bool {
+        if (m_iteration.found.load(std::memory_order_relaxed)) return false;
+        countNode();
+
+        auto h = m_solver.heuristic(cube, (m_iteration.rootParity + g) & 1);
+        if (g + h > m_iteration.bound) {
+            lowerTo(m_iteration.nextBound, g + h);
+            return false;
+        }
+        if (h == 0) return record();
+
+        for (int m = 0; m < moveCount; ++m) {
+            if (!allowedAfter(m, last, beforeLast)) continue;
+
+            auto child = cube;
+            applyMove(child, static_cast<Move>(m));
+            m_path.push_back(static_cast<Move>(m));
+            if (search(child, g + 1, m, last)) return true;
+            m_path.pop_back();
+        }
+        return false;
+    }
+
+    // Same as search() down to splitDepth, where the subtrees are collected instead of searched
+    auto collect(const PieceCube& cube, int g, int last, int beforeLast, std::vector<Subtree>& subtrees) -> bool {
+        if (g == splitDepth) {
+            subtrees.push_back(Subtree{ cube, m_path, last, beforeLast });
+            return false;
+        }
+
+        countNode();
+
+        auto h = m_solver.heuristic(cube, (m_iteration.rootParity + g) & 1);
+        if (g + h > m_iteration.bound) {
+            lowerTo(m_iteration.nextBound, g + h);
+            return false;
+        }
+        if (h == 0) return record();
+
+        for (int m = 0; m < moveCount; ++m) {
+            if (!allowedAfter(m, last, beforeLast)) continue;
+
+            auto child = cube;
+            applyMove(child, static_cast<Move>(m));
+            m_path.push_back(static_cast<Move>(m));
+            if (collect(child, g + 1, m, last, subtrees)) return true;
+            m_path.pop_back();
+        }
+        return false;
+    }
+
+    auto setPath(const std::vector<Move>& path) -> void { m_path = path; }
+
+private:
+    auto countNode() -> void {
+        if (++m_nodes == nodeFlushInterval) {
+            m_iteration.nodes += m_nodes;
+            m_nodes = 0;
+        }
+    }
+
+    // every solution within the bound is optimal, the first one wins
+    auto record() -> bool {
+        std::lock_guard lock(m_iteration.solutionMutex);
+        if (!m_iteration.found) {
+            m_iteration.solution = m_path;
+            m_iteration.found = true;
+        }
+        return true;
+    }
+
+    const KorfSolver& m_solver;
+    Iteration& m_iteration;
+    std::uint64_t m_nodes;
+    std::vector<Move> m_path;
+};
+
+} // namespace
+
+
+KorfSolver::KorfSolver(KorfSolverConfig config) :
+    m_config{ config },
+    m_stats{},
+    m_progress{},
+    m_corners{ PatternKind::CORNERS },
+    m_edgesLow{ PatternKind::EDGES_LOW },
+    m_edgesHigh{ PatternKind::EDGES_HIGH },
+    m_generatedDatabases{ 0 }
+{
+    bool cached = !m_config.databaseDirectory.empty();
+
+    for (auto* database : { &m_corners, &m_edgesLow, &m_edgesHigh }) {
+        auto path = m_config.databaseDirectory / (std::string(patternKindName(database->kind())) + ".pdb");
+        if (cached && database->load(path)) continue;
+
+        database->generate(m_config.threads);
+        ++m_generatedDatabases;
+
+        // a failing cache only costs the next start the generation time
+        if (cached) database->save(path);
+    }
+}
+
+auto KorfSolver::heuristic(const PieceCube& cube, int parity) const -> int {
+    auto h = std::max({ m_corners.distance(cube), m_edgesLow.distance(cube), m_edgesHigh.distance(cube) });
+    return h + ((h ^ parity) & 1);
+}
+
+auto KorfSolver::solve(const CubeState& state) -> std::optional<std::vector<Move>> {
+    return solve(cubieFromState(state));
+}
+
+auto KorfSolver::solve(const CubieCube& cube) -> std::optional<std::vector<Move>> {
+    PROFILE_SCOPE("KorfSolver::solve");
+
+    m_stats = KorfSolverStats{};
+    if (!isSolvable(cube)) return std::nullopt;
+
+    auto threads = m_config.threads;
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+
+    auto startTime = std::chrono::steady_clock::now();
+    auto start = pieceCubeFromCubie(cube);
+    auto rootParity = cornerParity(start);
+    auto bound = heuristic(start, rootParity);
+
+    while (bound <= m_config.maxDepth) {
+        Iteration iteration;
+        iteration.bound = bound;
+        iteration.rootParity = rootParity;
+        m_stats.bound = bound;
+
+        auto nodesBefore = m_stats.nodes;
+        auto report = [&]() {
+            m_stats.nodes = nodesBefore + iteration.nodes.load();
+            m_stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+            if (m_progress) m_progress(m_stats);
+        };
+
+        std::vector<Subtree> subtrees;
+        {
+            Searcher root(*this, iteration);
+            root.collect(start, 0, noMove, noMove, subtrees);
+        }
+
+        if (!iteration.found && !subtrees.empty()) {
+            std::atomic<std::size_t> nextSubtree{ 0 };
+            std::mutex doneMutex;
+            std::condition_variable doneCondition;
+            unsigned int finished = 0;
+
+            auto work = [&]() {
+                {
+                    Searcher searcher(*this, iteration);
+                    for (auto i = nextSubtree.fetch_add(1); i < subtrees.size() && !iteration.found; i = nextSubtree.fetch_add(1)) {
+                        const auto& subtree = subtrees[i];
+                        searcher.setPath(subtree.path);
+                        if (searcher.search(subtree.cube, splitDepth, subtree.last, subtree.beforeLast)) break;
+                    }
+                }
+
+                std::lock_guard lock(doneMutex);
+                ++finished;
+                doneCondition.notify_one();
+            };
+
+            auto workerCount = static_cast<unsigned int>(std::min<std::size_t>(threads, subtrees.size()));
+            std::vector<std::thread> workers;
+            for (unsigned int w = 0; w < workerCount; ++w) workers.emplace_back(work);
+
+            // the calling thread only reports progress
+            {
+                std::unique_lock lock(doneMutex);
+                while (!doneCondition.wait_for(lock, m_config.progressInterval, [&] { return finished == workerCount; })) {
+                    lock.unlock();
+                    report();
+                    lock.lock();
+                }
+            }
+
+            for (auto& worker : workers) worker.join();
+        }
+
+        report();
+        if (iteration.found) return iteration.solution;
+
+        bound = iteration.nextBound;
+    }
+
+    return std::nullopt;
+}
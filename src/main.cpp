@@ -2,6 +2,9 @@
 #include <string>
 #include <array>
 #include <cmath>
+#include <memory>
+#include <future>
+#include <optional>
 
 #include <glad/glad.h> 
 #include <GLFW/glfw3.h>
@@ -13,8 +16,16 @@
 #include "stb_image.h"
 
 #include "shader.h"
+#include "embedded_shaders.h"
 #include "camera.h"
 #include "rubiks_cube.h"
+#include "cfop_solver.h"
+#include "bidirectional_solver.h"
+#include "profiler.h"
+#include "cube_picker.h"
+#include "cube_mesh.h"
+#include "session_trace.h"
+#include "user_cache.h"
 
 
 // Config
@@ -22,6 +33,23 @@ const int windowWidth = 1400;
 const int windowHeight = 1000;
 const std::string windowTitle = "cube";
 
+// Rendering
+const bool renderOnDemand = true;    // block in glfwWaitEventsTimeout while nothing changes
+const double maxFrameRate = 144.0;   // frame-rate cap while rendering continuously, 0 = uncapped
+const double idleWakeupTime = 0.5;   // seconds between wakeups while idle
+bool frameDirty = true;              // set by callbacks when the next frame differs
+
+// Shaders, linked programs are cached per driver so warm starts skip compilation
+const std::string shaderCacheName = "cube_shader_cache"; // inside the user's cache directory
+
+// Profiling, only with -DCUBE_PROFILING: P writes the trace, it is also written on exit
+const std::string profileTracePath = "cube_trace.json";
+
+// Session recording, T starts and stops it, replay the trace with tools/replay_session.cpp
+const std::string sessionTracePath = "cube_session.trace";
+SessionTrace sessionTrace;
+bool recordingSession = false;
+
 // Delta Time
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
@@ -34,21 +62,41 @@ bool firstMouse = true;
 float lastX = (float)windowWidth / 2.0f;
 float lastY = (float)windowHeight / 2.0f;
 
+// Mouse turning, Tab switches between looking around and a free cursor that drags faces
+bool cursorMode = false;
+const float dragThreshold = 0.35f;          // world units the grabbed sticker has to be dragged for a turn
+std::optional<FaceletHit> grabbedFacelet;   // set while the left button holds a sticker
+
 // Rubiks Cube
 const float rotationSpeed = 200.0f;
 const float cubeSpacing = 1.02f;
 const int shuffleSteps = 50;
-RubiksCube rubiksCube(rotationSpeed, cubeSpacing, shuffleSteps);
+const std::size_t historyCheckpointInterval = 1024; // moves between full state snapshots
+RubiksCube rubiksCube(rotationSpeed, cubeSpacing, shuffleSteps, historyCheckpointInterval);
+
+// Solver, tables are built on first use
+const float solveStagePause = 0.75f; // seconds between solution stages
+std::unique_ptr<CfopSolver> cfopSolver;
+BidirectionalSolver optimalSolver({ .maxDepth = 14, .memoryLimit = std::size_t(1) << 30, .threads = 0 });
+std::future<std::optional<std::vector<Move>>> optimalSolve; // runs off the main thread, can take seconds
+CubeState optimalSolveStart;                                 // the solution only applies to this state
 
 
-auto process_input(GLFWwindow* window) -> void;
+auto process_input(GLFWwindow* window) -> bool;
 auto framebuffer_size_callback(GLFWwindow* window, int width, int height) -> void;
 auto mouse_callback(GLFWwindow* window, double xposIn, double yposIn) -> void;
+auto mouse_button_callback(GLFWwindow* window, int button, int action, int mods) -> void;
+auto projectionMatrix() -> glm::mat4;
+auto cursorToRay(GLFWwindow* window, double x, double y) -> Ray;
 auto key_callback(GLFWwindow* window, int key, int scancode, int action, int mods) -> void;
 auto scroll_callback(GLFWwindow* window, double xoffset, double yoffset) -> void;
+auto refresh_callback(GLFWwindow* window) -> void;
+auto optimalSolveReady() -> bool;
+auto finishOptimalSolve() -> void;
 
 
 auto main() -> int {
+    PROFILE_THREAD_NAME("main");
 
     glfwInit();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
@@ -73,8 +121,10 @@ auto main() -> int {
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
     glfwSetKeyCallback(window, key_callback);
     glfwSetScrollCallback(window, scroll_callback);
+    glfwSetWindowRefreshCallback(window, refresh_callback);
 
     glfwSetCursorPosCallback(window, mouse_callback);
+    glfwSetMouseButtonCallback(window, mouse_button_callback);
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 
 
@@ -84,83 +134,29 @@ auto main() -> int {
     }
 
     glEnable(GL_DEPTH_TEST);
+    glEnable(GL_CULL_FACE); // cubie triangles are wound counter clockwise seen from outside
 
-    // Create shader
-    Shader shader("rubiks_cube.vert", "rubiks_cube.frag");
+    // Create shader from the sources compiled into the binary, without a private cache directory there is no cache
+    Shader shader(ShaderSource{ "rubiks_cube", rubiksCubeVert, rubiksCubeFrag }, userCacheDirectory(shaderCacheName));
 
     // Initialize rubiks cube object
     rubiksCube.init();
 
-    float vertices[] = {
-        // pos.x, pos.y, pos.z, face index
-        -0.5f, -0.5f, -0.5f, 0.0f,
-        0.5f, -0.5f, -0.5f, 0.0f,
-        0.5f,  0.5f, -0.5f, 0.0f,
-        0.5f,  0.5f, -0.5f, 0.0f,
-        -0.5f,  0.5f, -0.5f, 0.0f,
-        -0.5f, -0.5f, -0.5f, 0.0f,
-
-        -0.5f, -0.5f,  0.5f, 1.0f,
-        0.5f, -0.5f,  0.5f, 1.0f,
-        0.5f,  0.5f,  0.5f, 1.0f,
-        0.5f,  0.5f,  0.5f, 1.0f,
-        -0.5f,  0.5f,  0.5f, 1.0f,
-        -0.5f, -0.5f,  0.5f, 1.0f,
-
-        -0.5f,  0.5f,  0.5f, 2.0f,
-        -0.5f,  0.5f, -0.5f, 2.0f,
-        -0.5f, -0.5f, -0.5f, 2.0f,
-        -0.5f, -0.5f, -0.5f, 2.0f,
-        -0.5f, -0.5f,  0.5f, 2.0f,
-        -0.5f,  0.5f,  0.5f, 2.0f,
-
-        0.5f,  0.5f,  0.5f, 3.0f,
-        0.5f,  0.5f, -0.5f, 3.0f,
-        0.5f, -0.5f, -0.5f, 3.0f,
-        0.5f, -0.5f, -0.5f, 3.0f,
-        0.5f, -0.5f,  0.5f, 3.0f,
-        0.5f,  0.5f,  0.5f, 3.0f,
-
-        -0.5f, -0.5f, -0.5f, 4.0f,
-        0.5f, -0.5f, -0.5f, 4.0f,
-        0.5f, -0.5f,  0.5f, 4.0f,
-        0.5f, -0.5f,  0.5f, 4.0f,
-        -0.5f, -0.5f,  0.5f, 4.0f,
-        -0.5f, -0.5f, -0.5f, 4.0f,
-
-        -0.5f,  0.5f, -0.5f, 5.0f,
-        0.5f,  0.5f, -0.5f, 5.0f,
-        0.5f,  0.5f,  0.5f, 5.0f,
-        0.5f,  0.5f,  0.5f, 5.0f,
-        -0.5f,  0.5f,  0.5f, 5.0f,
-        -0.5f,  0.5f, -0.5f, 5.0f,
-    };
-
-    unsigned int VAO, VBO;
-
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-
-    // configure cube
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    // bevelled cubie with inset stickers, drawn instanced
+    CubeMesh cubeMesh;
 
     // set mode
     //glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 
     while (!glfwWindowShouldClose(window)) {
+        PROFILE_SCOPE("frame");
+
         float currentFrame = static_cast<float>(glfwGetTime());
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
 
-        process_input(window);
+        bool cameraMoving = process_input(window);
+        finishOptimalSolve();
 
         glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -168,32 +164,58 @@ auto main() -> int {
         shader.use();
 
         // projection matrix
-        glm::mat4 projection = glm::perspective(
-            glm::radians(camera.m_zoom),
-            (float)windowWidth / (float)windowHeight,
-            0.1f,
-            100.0f
-        );
+        glm::mat4 projection = projectionMatrix();
         shader.setMat4("projection", projection);
 
         // view matrix
         glm::mat4 view = camera.getViewMatrix();
         shader.setMat4("view", view);
 
-        glBindVertexArray(VAO);
-
         // update and draw rubiks cube
         rubiksCube.update(deltaTime);
-        rubiksCube.draw(shader);
+        rubiksCube.draw(cubeMesh);
 
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        {
+            PROFILE_SCOPE("glfwSwapBuffers");
+            glfwSwapBuffers(window);
+        }
+        frameDirty = false;
+
+        PROFILE_SCOPE("wait for events");
+
+        if (renderOnDemand && !cameraMoving && !rubiksCube.isBusy()) {
+            // static frame: sleep until input or a queued move changes it
+            while (!frameDirty && !rubiksCube.isBusy() && !optimalSolveReady() && !glfwWindowShouldClose(window)) {
+                glfwWaitEventsTimeout(idleWakeupTime);
+            }
+
+            // the idle time must not show up as a huge deltaTime
+            lastFrame = static_cast<float>(glfwGetTime());
+        }
+        else if (maxFrameRate > 0.0) {
+            // keep handling events while waiting for the next frame slot, any event (e.g. a mouse
+            // move) ends a wait early, so wait again for whatever is left of the slot
+            double nextFrame = currentFrame + 1.0 / maxFrameRate;
+            glfwPollEvents();
+            for (double now = glfwGetTime(); now < nextFrame && !glfwWindowShouldClose(window); now = glfwGetTime()) {
+                glfwWaitEventsTimeout(nextFrame - now);
+            }
+        }
+        else {
+            glfwPollEvents();
+        }
     }
 
-    shader.deleteShader();
+    if constexpr (profilingEnabled) {
+        if (Profiler::writeChromeTrace(profileTracePath)) std::cout << "trace written to " << profileTracePath << "\n";
+    }
+    if (recordingSession && sessionTrace.save(sessionTracePath)) std::cout << "session written to " << sessionTracePath << "\n";
+
+    // the search posts an empty event when done, which needs glfw
+    if (optimalSolve.valid()) optimalSolve.wait();
 
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
+    shader.deleteShader();
+    cubeMesh.destroy();
 
     glfwDestroyWindow(window);
     glfwTerminate();
@@ -201,24 +223,69 @@ auto main() -> int {
     return 0;
 }
 
-auto process_input(GLFWwindow* window) -> void {
+// Returns true while a camera key is held, the frame then has to be redrawn continuously
+auto process_input(GLFWwindow* window) -> bool {
+    PROFILE_FUNCTION();
+
     if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) glfwSetWindowShouldClose(window, true);
 
-    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) camera.processKeyboard(CameraMovement::FORWARD, deltaTime);
-    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) camera.processKeyboard(CameraMovement::BACKWARD, deltaTime);
-    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) camera.processKeyboard(CameraMovement::LEFT, deltaTime);
-    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) camera.processKeyboard(CameraMovement::RIGHT, deltaTime);
-    if (glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS) camera.processKeyboard(CameraMovement::UP, deltaTime);
-    if (glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS) camera.processKeyboard(CameraMovement::DOWN, deltaTime);
+    const std::array<std::pair<int, CameraMovement>, 6> bindings = { {
+        { GLFW_KEY_W, CameraMovement::FORWARD },
+        { GLFW_KEY_S, CameraMovement::BACKWARD },
+        { GLFW_KEY_A, CameraMovement::LEFT },
+        { GLFW_KEY_D, CameraMovement::RIGHT },
+        { GLFW_KEY_UP, CameraMovement::UP },
+        { GLFW_KEY_DOWN, CameraMovement::DOWN },
+    } };
+
+    bool moved = false;
+    for (const auto& [key, direction] : bindings) {
+        if (glfwGetKey(window, key) == GLFW_PRESS) {
+            camera.processKeyboard(direction, deltaTime);
+            moved = true;
+        }
+    }
+
+    return moved;
+}
+
+auto projectionMatrix() -> glm::mat4
+{
+    return glm::perspective(
+        glm::radians(camera.m_zoom),
+        (float)windowWidth / (float)windowHeight,
+        0.1f,
+        100.0f
+    );
+}
+
+auto cursorToRay(GLFWwindow* window, double x, double y) -> Ray
+{
+    int width, height;
+    glfwGetWindowSize(window, &width, &height);
+    return cursorRay(x, y, width, height, projectionMatrix(), camera.getViewMatrix());
 }
 
 auto framebuffer_size_callback(GLFWwindow* window, int width, int height) -> void
 {
     glViewport(0, 0, width, height);
+    frameDirty = true;
 }
 
 auto mouse_callback(GLFWwindow* window, double xposIn, double yposIn) -> void
 {
+    if (cursorMode) {
+        // one turn per grab, queued right away so the next frame already starts it
+        if (grabbedFacelet) {
+            if (auto turn = dragTurn(*grabbedFacelet, cursorToRay(window, xposIn, yposIn), cubeSpacing, dragThreshold)) {
+                rubiksCube.addMove(RubiksCube::toRotationConfig(moveFromAxis(turn->axis, turn->side, turn->direction)));
+                grabbedFacelet.reset();
+                frameDirty = true;
+            }
+        }
+        return;
+    }
+
     float xpos = static_cast<float>(xposIn);
     float ypos = static_cast<float>(yposIn);
 
@@ -234,72 +301,175 @@ auto mouse_callback(GLFWwindow* window, double xposIn, double yposIn) -> void
     lastY = ypos;
 
     camera.processMouseMovement(xoffset, yoffset);
+    frameDirty = true;
 }
 
-auto key_callback(GLFWwindow* window, int key, int scancode, int action, int mods) -> void
+auto mouse_button_callback(GLFWwindow* window, int button, int action, int mods) -> void
 {
+    if (!cursorMode || button != GLFW_MOUSE_BUTTON_LEFT) return;
+
     if (action == GLFW_PRESS) {
-        if (rubiksCube.isAnimating()) return;
+        double x, y;
+        glfwGetCursorPos(window, &x, &y);
+        grabbedFacelet = pickFacelet(cursorToRay(window, x, y), cubeSpacing);
+    }
+    else if (action == GLFW_RELEASE) {
+        grabbedFacelet.reset();
+    }
+}
+
+auto key_callback(GLFWwindow* window, int key, int scancode, int action, int mods) -> void
+{
+    frameDirty = true;
 
+    if (action == GLFW_PRESS) {
+        // turns pressed during an animation are queued behind it
         if (key == GLFW_KEY_1) {  // rotate front
             auto cfg = RubiksCube::RotationConfig{ .axis = glm::vec3(0, 0, 1), .side = 1, .direction = -1 };
-            rubiksCube.initRotation(cfg);
+            rubiksCube.addMove(cfg);
         }
         if (key == GLFW_KEY_F1) { // rotate front inverted
             auto cfg = RubiksCube::RotationConfig{ .axis = glm::vec3(0, 0, 1), .side = 1, .direction = 1 };
-            rubiksCube.initRotation(cfg);
+            rubiksCube.addMove(cfg);
         }
         if (key == GLFW_KEY_2) { // rotate back
             auto cfg = RubiksCube::RotationConfig{ .axis = glm::vec3(0, 0, 1), .side = -1, .direction = -1 };
-            rubiksCube.initRotation(cfg);
+            rubiksCube.addMove(cfg);
         }
         if (key == GLFW_KEY_F2) { // rotate back inverted
             auto cfg = RubiksCube::RotationConfig{ .axis = glm::vec3(0, 0, 1), .side = -1, .direction = 1 };
-            rubiksCube.initRotation(cfg);
+            rubiksCube.addMove(cfg);
         }
         if (key == GLFW_KEY_3) { // rotate left
             auto cfg = RubiksCube::RotationConfig{ .axis = glm::vec3(1, 0, 0), .side = -1, .direction = -1 };
-            rubiksCube.initRotation(cfg);
+            rubiksCube.addMove(cfg);
         }
         if (key == GLFW_KEY_F3) { // rotate left inverted
             auto cfg = RubiksCube::RotationConfig{ .axis = glm::vec3(1, 0, 0), .side = -1, .direction = 1 };
-            rubiksCube.initRotation(cfg);
+            rubiksCube.addMove(cfg);
         }
         if (key == GLFW_KEY_4) { // rotate right
             auto cfg = RubiksCube::RotationConfig{ .axis = glm::vec3(1, 0, 0), .side = 1, .direction = -1 };
-            rubiksCube.initRotation(cfg);
+            rubiksCube.addMove(cfg);
         }
         if (key == GLFW_KEY_F4) { // rotate right inverted
             auto cfg = RubiksCube::RotationConfig{ .axis = glm::vec3(1, 0, 0), .side = 1, .direction = 1 };
-            rubiksCube.initRotation(cfg);
+            rubiksCube.addMove(cfg);
         }
         if (key == GLFW_KEY_5) { // rotate up
             auto cfg = RubiksCube::RotationConfig{ .axis = glm::vec3(0, 1, 0), .side = 1, .direction = -1 };
-            rubiksCube.initRotation(cfg);
+            rubiksCube.addMove(cfg);
         }
         if (key == GLFW_KEY_F5) { // rotate up inverted
             auto cfg = RubiksCube::RotationConfig{ .axis = glm::vec3(0, 1, 0), .side = 1, .direction = 1 };
-            rubiksCube.initRotation(cfg);
+            rubiksCube.addMove(cfg);
         }
         if (key == GLFW_KEY_6) { // rotate down
             auto cfg = RubiksCube::RotationConfig{ .axis = glm::vec3(0, 1, 0), .side = -1, .direction = -1 };
-            rubiksCube.initRotation(cfg);
+            rubiksCube.addMove(cfg);
         }
         if (key == GLFW_KEY_F6) { // rotate down inverted
             auto cfg = RubiksCube::RotationConfig{ .axis = glm::vec3(0, 1, 0), .side = -1, .direction = 1 };
-            rubiksCube.initRotation(cfg);
+            rubiksCube.addMove(cfg);
+        }
+        if (key == GLFW_KEY_TAB) { // toggle between camera look and dragging faces with the cursor
+            cursorMode = !cursorMode;
+            grabbedFacelet.reset();
+            firstMouse = true;
+            glfwSetInputMode(window, GLFW_CURSOR, cursorMode ? GLFW_CURSOR_NORMAL : GLFW_CURSOR_DISABLED);
         }
         if (key == GLFW_KEY_Q) { // shuffle cube randomly
             rubiksCube.shuffle();
         }
+        if (key == GLFW_KEY_Z) { // undo last move
+            rubiksCube.undo();
+        }
+        if (key == GLFW_KEY_Y) { // redo move
+            rubiksCube.redo();
+        }
+        if (key == GLFW_KEY_HOME) { // jump to the start of the history
+            rubiksCube.seekHistory(0);
+        }
+        if (key == GLFW_KEY_END) { // jump to the end of the history
+            rubiksCube.seekHistory(rubiksCube.history().size());
+        }
+        if (key == GLFW_KEY_C && !rubiksCube.isBusy()) { // solve with CFOP, pausing after each stage
+            if (!cfopSolver) cfopSolver = std::make_unique<CfopSolver>();
+
+            auto stages = cfopSolver->solve(rubiksCube.getCubeState());
+            for (const auto& stage : stages) {
+                std::cout << stage.label << ": " << movesToString(stage.moves) << "\n";
+            }
+            rubiksCube.addSolution(stages, solveStagePause);
+        }
+        if (key == GLFW_KEY_O && !rubiksCube.isBusy()) { // optimal solve, meant for short hand made scrambles
+            if (optimalSolve.valid()) {
+                std::cout << "optimal solve already running\n";
+            }
+            else {
+                // a deep scramble can search for seconds, the window keeps rendering meanwhile
+                optimalSolveStart = rubiksCube.getCubeState();
+                optimalSolve = std::async(std::launch::async, [state = optimalSolveStart] {
+                    auto solution = optimalSolver.solve(state);
+                    glfwPostEmptyEvent();
+                    return solution;
+                });
+                std::cout << "searching for an optimal solution...\n";
+            }
+        }
         if (key == GLFW_KEY_L) {
-            CubeState s = rubiksCube.getCubeState();
+            const auto& s = rubiksCube.getCubeState();
             RubiksCube::printCubeState(s);
         }
+        if (key == GLFW_KEY_T && (recordingSession || !rubiksCube.isBusy())) { // record a session trace, starts at rest
+            recordingSession = !recordingSession;
+            if (recordingSession) {
+                sessionTrace.clear();
+                sessionTrace.addState(rubiksCube.getCubeState());
+                rubiksCube.setTrace(&sessionTrace);
+                std::cout << "recording session\n";
+            }
+            else {
+                rubiksCube.setTrace(nullptr);
+                if (sessionTrace.save(sessionTracePath)) std::cout << "session written to " << sessionTracePath << "\n";
+            }
+        }
+        if constexpr (profilingEnabled) {
+            if (key == GLFW_KEY_P && Profiler::writeChromeTrace(profileTracePath)) { // write the profiler trace
+                std::cout << "trace written to " << profileTracePath << "\n";
+            }
+        }
     }
 }
 
 auto scroll_callback(GLFWwindow* window, double xoffset, double yoffset) -> void
 {
     camera.processMouseScroll(static_cast<float>(yoffset));
+    frameDirty = true;
+}
+
+auto refresh_callback(GLFWwindow* window) -> void
+{
+    frameDirty = true;
+}
+
+auto optimalSolveReady() -> bool {
+    return optimalSolve.valid() && optimalSolve.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+// Queues the finished optimal solution, unless the cube was turned while searching
+auto finishOptimalSolve() -> void {
+    if (!optimalSolveReady()) return;
+
+    auto solution = optimalSolve.get();
+    if (!solution) {
+        std::cout << "no optimal solution within the depth and memory limits\n";
+    }
+    else if (rubiksCube.isBusy() || !(rubiksCube.getCubeState() == optimalSolveStart)) {
+        std::cout << "cube changed during the optimal solve, solution dropped\n";
+    }
+    else {
+        std::cout << "optimal (" << solution->size() << "): " << movesToString(*solution) << "\n";
+        rubiksCube.addSolution({ SolveStage{ "optimal", *solution } }, 0.0f);
+    }
 }
@@ -0,0 +1,67 @@
+#include "move_history.h"
+
+#include <algorithm>
+
+
+MoveHistory::MoveHistory(std::size_t checkpointInterval, const CubeState& initial) :
+    m_checkpointInterval{ std::max<std::size_t>(checkpointInterval, 1) },
+    m_moves{},
+    m_checkpoints{ initial },
+    m_cursor{ 0 }
+{
+}
+
+auto MoveHistory::record(Move move) -> void {
+    if (m_cursor < m_moves.size()) {
+        // new move after an undo, the redo tail and its checkpoints are stale
+        m_moves.resize(m_cursor);
+        m_checkpoints.resize(m_cursor / m_checkpointInterval + 1);
+    }
+
+    m_moves.push_back(move);
+    m_cursor = m_moves.size();
+
+    if (m_cursor % m_checkpointInterval == 0) {
+        auto state = m_checkpoints.back();
+        for (auto i = m_cursor - m_checkpointInterval; i < m_cursor; ++i) {
+            applyMove(state, m_moves[i]);
+        }
+        m_checkpoints.push_back(state);
+    }
+}
+
+auto MoveHistory::undo() -> std::optional<Move> {
+    if (!canUndo()) return std::nullopt;
+
+    --m_cursor;
+    return inverseMove(m_moves[m_cursor]);
+}
+
+auto MoveHistory::redo() -> std::optional<Move> {
+    if (!canRedo()) return std::nullopt;
+
+    return m_moves[m_cursor++];
+}
+
+auto MoveHistory::stateAt(std::size_t position) const -> CubeState {
+    position = std::min(position, m_moves.size());
+
+    auto checkpoint = position / m_checkpointInterval;
+    auto state = m_checkpoints[checkpoint];
+    for (auto i = checkpoint * m_checkpointInterval; i < position; ++i) {
+        applyMove(state, m_moves[i]);
+    }
+
+    return state;
+}
+
+auto MoveHistory::seek(std::size_t position) -> CubeState {
+    m_cursor = std::min(position, m_moves.size());
+    return stateAt(m_cursor);
+}
+
+auto MoveHistory::clear(const CubeState& initial) -> void {
+    m_moves.clear();
+    m_checkpoints.assign(1, initial);
+    m_cursor = 0;
+}
@@ -0,0 +1,397 @@
+#include "pattern_database.h"
+
+#include <bit>
+#include <atomic>
+#include <thread>
+#include <random>
+#include <string>
+#include <fstream>
+#include <algorithm>
+#include <stdexcept>
+
+
+namespace {
+
+constexpr int cornerPositionCount = cornerCount * 3;
+constexpr int edgePositionCount = edgeCount * 2;
+constexpr int edgeSubsetSize = 6;
+constexpr std::size_t edgeSubsetPermCount = 12 * 11 * 10 * 9 * 8 * 7;
+
+constexpr char databaseMagic[8] = { 'C', 'U', 'B', 'E', 'P', 'D', 'B', '2' };
+
+// FNV-1a over the table, catches truncated and corrupted files
+auto tableChecksum(const std::vector<std::uint8_t>& table) -> std::uint64_t {
+    std::uint64_t hash = 0xcbf29ce484222325ull;
+    for (auto byte : table) {
+        hash ^= byte;
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+struct PositionTables {
+    // [move][slot * 3 + twist], [move][slot * 2 + flip]
+    std::array<std::array<std::uint8_t, cornerPositionCount>, moveCount> corners;
+    std::array<std::array<std::uint8_t, edgePositionCount>, moveCount> edges;
+};
+
+auto buildPositionTables() -> PositionTables {
+    auto t = PositionTables{};
+
+    // applyMove(CubieCube&) moves the piece in slot m.cornerPerm[i] to slot i
+    for (int move = 0; move < moveCount; ++move) {
+        const auto& m = moveCubie(static_cast<Move>(move));
+
+        for (int slot = 0; slot < cornerCount; ++slot) {
+            int from = m.cornerPerm[slot];
+            for (int twist = 0; twist < 3; ++twist) {
+                t.corners[move][from * 3 + twist] = static_cast<std::uint8_t>(slot * 3 + (twist + m.cornerOrient[slot]) % 3);
+            }
+        }
+
+        for (int slot = 0; slot < edgeCount; ++slot) {
+            int from = m.edgePerm[slot];
+            for (int flip = 0; flip < 2; ++flip) {
+                t.edges[move][from * 2 + flip] = static_cast<std::uint8_t>(slot * 2 + (flip ^ m.edgeOrient[slot]));
+            }
+        }
+    }
+
+    return t;
+}
+
+auto positionTables() -> const PositionTables& {
+    static const PositionTables t = buildPositionTables();
+    return t;
+}
+
+// Lehmer digit of slot among the slots not used yet
+auto lehmerDigit(unsigned int& used, int slot) -> int {
+    int digit = slot - std::popcount(used & ((1u << slot) - 1));
+    used |= 1u << slot;
+    return digit;
+}
+
+// The digit-th slot not used yet
+auto slotFromDigit(unsigned int& used, int digit) -> int {
+    int slot = 0;
+    for (;; ++slot) {
+        if (used & (1u << slot)) continue;
+        if (digit-- == 0) break;
+    }
+    used |= 1u << slot;
+    return slot;
+}
+
+auto cornerIndex(const PieceCube& cube) -> std::size_t {
+    unsigned int used = 0;
+    std::size_t perm = 0;
+    int twist = 0;
+
+    for (int piece = 0; piece < cornerCount; ++piece) {
+        perm = perm * (cornerCount - piece) + lehmerDigit(used, cube.corners[piece] / 3);
+    }
+    for (int piece = 0; piece < cornerCount - 1; ++piece) twist = twist * 3 + cube.corners[piece] % 3;
+
+    return perm * cornerOrientCoordCount + twist;
+}
+
+auto edgeSubsetIndex(const PieceCube& cube, int first) -> std::size_t {
+    unsigned int used = 0;
+    std::size_t perm = 0;
+    int flips = 0;
+
+    for (int i = 0; i < edgeSubsetSize; ++i) {
+        auto position = cube.edges[first + i];
+        perm = perm * (edgeCount - i) + lehmerDigit(used, position >> 1);
+        flips = (flips << 1) | (position & 1);
+    }
+
+    return (perm << edgeSubsetSize) | flips;
+}
+
+auto firstEdge(PatternKind kind) -> int {
+    return (kind == PatternKind::EDGES_LOW) ? 0 : edgeSubsetSize;
+}
+
+// Inverse of PatternDatabase::index(), pieces outside the pattern stay solved
+auto pieceCubeFromIndex(PatternKind kind, std::size_t index) -> PieceCube {
+    auto cube = pieceCubeFromCubie(solvedCubieCube());
+    unsigned int used = 0;
+
+    if (kind == PatternKind::CORNERS) {
+        auto twist = static_cast<int>(index % cornerOrientCoordCount);
+        auto perm = index / cornerOrientCoordCount;
+
+        int digits[cornerCount];
+        for (int piece = cornerCount; piece-- > 0;) {
+            digits[piece] = static_cast<int>(perm % (cornerCount - piece));
+            perm /= cornerCount - piece;
+        }
+
+        int twists[cornerCount];
+        int sum = 0;
+        for (int piece = cornerCount - 1; piece-- > 0;) {
+            twists[piece] = twist % 3;
+            sum += twist % 3;
+            twist /= 3;
+        }
+        twists[cornerCount - 1] = (3 - sum % 3) % 3;
+
+        for (int piece = 0; piece < cornerCount; ++piece) {
+            cube.corners[piece] = static_cast<std::uint8_t>(slotFromDigit(used, digits[piece]) * 3 + twists[piece]);
+        }
+        return cube;
+    }
+
+    auto first = firstEdge(kind);
+    auto flips = static_cast<int>(index & ((1u << edgeSubsetSize) - 1));
+    auto perm = index >> edgeSubsetSize;
+
+    int digits[edgeSubsetSize];
+    for (int i = edgeSubsetSize; i-- > 0;) {
+        digits[i] = static_cast<int>(perm % (edgeCount - i));
+        perm /= edgeCount - i;
+    }
+
+    for (int i = 0; i < edgeSubsetSize; ++i) {
+        auto flip = (flips >> (edgeSubsetSize - 1 - i)) & 1;
+        cube.edges[first + i] = static_cast<std::uint8_t>(slotFromDigit(used, digits[i]) * 2 + flip);
+    }
+    return cube;
+}
+
+auto loadDistance(std::uint8_t* table, std::size_t index) -> int {
+    auto byte = std::atomic_ref<std::uint8_t>(table[index >> 1]).load(std::memory_order_relaxed);
+    return (byte >> ((index & 1) * 4)) & 0xf;
+}
+
+// Sets an unknown entry, false if it already had a distance
+auto storeDistance(std::uint8_t* table, std::size_t index, int distance) -> bool {
+    auto byte = std::atomic_ref<std::uint8_t>(table[index >> 1]);
+    auto shift = static_cast<int>((index & 1) * 4);
+
+    auto old = byte.load(std::memory_order_relaxed);
+    while (((old >> shift) & 0xf) == PatternDatabase::unknownDistance) {
+        auto desired = static_cast<std::uint8_t>((old & ~(0xf << shift)) | (distance << shift));
+        if (byte.compare_exchange_weak(old, desired, std::memory_order_relaxed)) return true;
+    }
+    return false;
+}
+
+} // namespace
+
+
+auto pieceCubeFromCubie(const CubieCube& cube) -> PieceCube {
+    auto pieces = PieceCube{};
+    for (int slot = 0; slot < cornerCount; ++slot) {
+        pieces.corners[cube.cornerPerm[slot]] = static_cast<std::uint8_t>(slot * 3 + cube.cornerOrient[slot]);
+    }
+    for (int slot = 0; slot < edgeCount; ++slot) {
+        pieces.edges[cube.edgePerm[slot]] = static_cast<std::uint8_t>(slot * 2 + cube.edgeOrient[slot]);
+    }
+    return pieces;
+}
+
+auto cubieFromPieceCube(const PieceCube& pieces) -> CubieCube {
+    auto cube = CubieCube{};
+    for (int piece = 0; piece < cornerCount; ++piece) {
+        cube.cornerPerm[pieces.corners[piece] / 3] = static_cast<std::uint8_t>(piece);
+        cube.cornerOrient[pieces.corners[piece] / 3] = static_cast<std::uint8_t>(pieces.corners[piece] % 3);
+    }
+    for (int piece = 0; piece < edgeCount; ++piece) {
+        cube.edgePerm[pieces.edges[piece] >> 1] = static_cast<std::uint8_t>(piece);
+        cube.edgeOrient[pieces.edges[piece] >> 1] = static_cast<std::uint8_t>(pieces.edges[piece] & 1);
+    }
+    return cube;
+}
+
+auto applyMove(PieceCube& cube, Move move) -> void {
+    const auto& t = positionTables();
+    const auto& corners = t.corners[static_cast<int>(move)];
+    const auto& edges = t.edges[static_cast<int>(move)];
+
+    for (auto& position : cube.corners) position = corners[position];
+    for (auto& position : cube.edges) position = edges[position];
+}
+
+auto cornerParity(const PieceCube& cube) -> int {
+    unsigned int used = 0;
+    int inversions = 0;
+    for (int piece = 0; piece < cornerCount; ++piece) inversions += lehmerDigit(used, cube.corners[piece] / 3);
+    return inversions & 1;
+}
+
+auto patternKindName(PatternKind kind) -> const char* {
+    switch (kind) {
+    case PatternKind::CORNERS: return "corners";
+    case PatternKind::EDGES_LOW: return "edges_low";
+    case PatternKind::EDGES_HIGH: return "edges_high";
+    default: return "unknown";
+    }
+}
+
+PatternDatabase::PatternDatabase(PatternKind kind) :
+    m_kind{ kind },
+    m_size{ entryCount(kind) },
+    m_table{}
+{
+}
+
+auto PatternDatabase::entryCount(PatternKind kind) -> std::size_t {
+    if (kind == PatternKind::CORNERS) return std::size_t(cornerPermCoordCount) * cornerOrientCoordCount;
+    return edgeSubsetPermCount << edgeSubsetSize;
+}
+
+auto PatternDatabase::index(PatternKind kind, const PieceCube& cube) -> std::size_t {
+    if (kind == PatternKind::CORNERS) return cornerIndex(cube);
+    return edgeSubsetIndex(cube, firstEdge(kind));
+}
+
+auto PatternDatabase::generate(unsigned int threads) -> void {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+
+    m_table.assign((m_size + 1) / 2, 0xff);
+    auto* table = m_table.data();
+    storeDistance(table, index(m_kind, pieceCubeFromCubie(solvedCubieCube())), 0);
+
+    constexpr std::size_t chunkSize = std::size_t(1) << 16;
+    auto chunkCount = (m_size + chunkSize - 1) / chunkSize;
+
+    std::size_t visited = 1;
+    std::size_t levelSize = 1;
+
+    for (int depth = 0; visited < m_size; ++depth) {
+        if (depth + 1 >= unknownDistance) throw std::runtime_error("pattern database distance does not fit in 4 bits!");
+
+        // expanding the level is cheaper while it is smaller than the unvisited rest
+        bool backward = levelSize > m_size - visited;
+
+        std::atomic<std::size_t> nextChunk{ 0 };
+        std::atomic<std::size_t> added{ 0 };
+
+        auto work = [&]() {
+            std::size_t count = 0;
+
+            for (auto chunk = nextChunk.fetch_add(1); chunk < chunkCount; chunk = nextChunk.fetch_add(1)) {
+                auto end = std::min(m_size, (chunk + 1) * chunkSize);
+
+                for (auto i = chunk * chunkSize; i < end; ++i) {
+                    auto d = loadDistance(table, i);
+
+                    if (!backward && d == depth) {
+                        auto cube = pieceCubeFromIndex(m_kind, i);
+                        for (int m = 0; m < moveCount; ++m) {
+                            auto child = cube;
+                            applyMove(child, static_cast<Move>(m));
+                            if (storeDistance(table, index(m_kind, child), depth + 1)) ++count;
+                        }
+                    }
+                    else if (backward && d == unknownDistance) {
+                        auto cube = pieceCubeFromIndex(m_kind, i);
+                        for (int m = 0; m < moveCount; ++m) {
+                            auto child = cube;
+                            applyMove(child, static_cast<Move>(m));
+                            if (loadDistance(table, index(m_kind, child)) == depth) {
+                                if (storeDistance(table, i, depth + 1)) ++count;
+                                break;
+                            }
+                        }
+                    }
+                }
+            }
+
+            added += count;
+        };
+
+        if (threads == 1) {
+            work();
+        }
+        else {
+            std::vector<std::thread> workers;
+            for (unsigned int t = 0; t < threads; ++t) workers.emplace_back(work);
+            for (auto& worker : workers) worker.join();
+        }
+
+        levelSize = added;
+        visited += levelSize;
+        if (levelSize == 0) throw std::runtime_error("pattern database search did not reach every entry!");
+    }
+}
+
+// File: magic, u8 kind, u64 entry count, the nibble table, u64 checksum of the table
+auto PatternDatabase::load(const std::filesystem::path& path) -> bool {
+    std::ifstream file{ path, std::ios::binary };
+    if (!file.is_open()) return false;
+
+    char magic[sizeof(databaseMagic)];
+    std::uint8_t kind = 0;
+    std::uint64_t size = 0;
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char*>(&kind), sizeof(kind));
+    file.read(reinterpret_cast<char*>(&size), sizeof(size));
+    if (!file || !std::equal(magic, magic + sizeof(magic), databaseMagic)) return false;
+    if (kind != static_cast<std::uint8_t>(m_kind) || size != m_size) return false;
+
+    std::vector<std::uint8_t> table((m_size + 1) / 2);
+    std::uint64_t checksum = 0;
+    file.read(reinterpret_cast<char*>(table.data()), static_cast<std::streamsize>(table.size()));
+    file.read(reinterpret_cast<char*>(&checksum), sizeof(checksum));
+    if (!file || tableChecksum(table) != checksum) return false;
+
+    // A wrong entry that overestimates makes the solver return non-optimal solutions
+    // without noticing, so the table must also look like a finished search: only the
+    // solved pattern at distance 0 and no entry left unknown.
+    m_table.swap(table);
+    auto solved = index(m_kind, pieceCubeFromCubie(solvedCubieCube()));
+    bool valid = distance(solved) == 0;
+    for (std::size_t i = 0; i < m_size && valid; ++i) {
+        auto d = distance(i);
+        valid = d != unknownDistance && (d != 0 || i == solved);
+    }
+
+    if (!valid) m_table.swap(table);
+    return valid;
+}
+
+auto PatternDatabase::save(const std::filesystem::path& path) const -> bool {
+    if (m_table.empty()) return false;
+
+    std::error_code error;
+    if (path.has_parent_path()) std::filesystem::create_directories(path.parent_path(), error);
+
+    // write next to the target and rename, a concurrent load never sees a half written table
+    auto tempPath = path;
+    tempPath += ".tmp" + std::to_string(std::random_device{}());
+    {
+        std::ofstream file{ tempPath, std::ios::binary | std::ios::trunc };
+        if (!file.is_open()) return false;
+
+        auto kind = static_cast<std::uint8_t>(m_kind);
+        auto size = static_cast<std::uint64_t>(m_size);
+        file.write(databaseMagic, sizeof(databaseMagic));
+        file.write(reinterpret_cast<const char*>(&kind), sizeof(kind));
+        file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+        auto checksum = tableChecksum(m_table);
+        file.write(reinterpret_cast<const char*>(m_table.data()), static_cast<std::streamsize>(m_table.size()));
+        file.write(reinterpret_cast<const char*>(&checksum), sizeof(checksum));
+        if (!file) {
+            file.close();
+            std::filesystem::remove(tempPath, error);
+            return false;
+        }
+    }
+
+    std::filesystem::rename(tempPath, path, error);
+    if (error) {
+        std::filesystem::remove(tempPath, error);
+        return false;
+    }
+    return true;
+}
+
+auto PatternDatabase::histogram() const -> std::array<std::uint64_t, 16> {
+    auto counts = std::array<std::uint64_t, 16>{};
+    for (std::size_t i = 0; i < m_size && !m_table.empty(); ++i) ++counts[distance(i)];
+    return counts;
+}
@@ -0,0 +1,183 @@
+#include "profiler.h"
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <thread>
+#include <fstream>
+#include <algorithm>
+
+
+namespace {
+
+struct Event {
+    const char* name;
+    std::uint64_t start;
+    std::uint64_t end;
+};
+
+// An event in the ring, relaxed atomics so that a concurrent reader is no data race.
+// Torn copies are detected by the seqlock on ThreadBuffer::written and dropped.
+struct EventSlot {
+    std::atomic<const char*> name = nullptr;
+    std::atomic<std::uint64_t> start = 0;
+    std::atomic<std::uint64_t> end = 0;
+};
+
+// Single writer ring buffer, events below `written - eventsPerThread` have been overwritten
+struct ThreadBuffer {
+    std::vector<EventSlot> events = std::vector<EventSlot>(Profiler::eventsPerThread);
+    std::atomic<std::uint64_t> written = 0;
+    std::atomic<std::uint64_t> cleared = 0;
+    std::uint32_t id = 0;
+    std::string name;
+};
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers; // kept after their thread exits
+
+    // reference point for converting ticks to microseconds
+    std::uint64_t startTicks = Profiler::now();
+    std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+};
+
+auto registry() -> Registry& {
+    static Registry r;
+    return r;
+}
+
+auto threadBuffer() -> ThreadBuffer& {
+    thread_local std::shared_ptr<ThreadBuffer> buffer = [] {
+        auto& r = registry();
+        auto b = std::make_shared<ThreadBuffer>();
+
+        std::lock_guard lock{ r.mutex };
+        b->id = static_cast<std::uint32_t>(r.buffers.size() + 1);
+        b->name = "thread " + std::to_string(b->id);
+        r.buffers.push_back(b);
+        return b;
+    }();
+    return *buffer;
+}
+
+auto writeJsonString(std::ostream& out, const std::string& s) -> void {
+    out << '"';
+    for (auto c : s) {
+        if (c == '"' || c == '\\') out << '\\' << c;
+        else if (static_cast<unsigned char>(c) < 0x20) out << ' ';
+        else out << c;
+    }
+    out << '"';
+}
+
+} // namespace
+
+
+auto Profiler::record(const char* name, std::uint64_t start, std::uint64_t end) -> void {
+    auto& buffer = threadBuffer();
+
+    // the fence orders the slot stores after the release of index, so a reader that sees any
+    // of them also sees written >= index and drops the event it overwrote
+    auto index = buffer.written.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    auto& slot = buffer.events[index % eventsPerThread];
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.start.store(start, std::memory_order_relaxed);
+    slot.end.store(end, std::memory_order_relaxed);
+    buffer.written.store(index + 1, std::memory_order_release);
+}
+
+auto Profiler::setThreadName(const std::string& name) -> void {
+    auto& buffer = threadBuffer();
+
+    std::lock_guard lock{ registry().mutex };
+    buffer.name = name;
+}
+
+auto Profiler::writeChromeTrace(const std::filesystem::path& path) -> bool {
+    auto& r = registry();
+
+    // ticks per microsecond measured over the whole run
+    auto ticks = static_cast<double>(now() - r.startTicks);
+    auto micros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - r.startTime).count();
+#ifdef CUBE_PROFILER_RDTSC
+    auto ticksPerMicro = (micros > 0.0) ? ticks / micros : 1.0;
+#else
+    auto ticksPerMicro = 1000.0;
+    (void)ticks;
+    (void)micros;
+#endif
+
+    auto toMicros = [&](std::uint64_t t) {
+        return static_cast<double>(static_cast<std::int64_t>(t - r.startTicks)) / ticksPerMicro;
+    };
+
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    std::vector<std::string> names;
+    {
+        std::lock_guard lock{ r.mutex };
+        buffers = r.buffers;
+        for (const auto& b : buffers) names.push_back(b->name);
+    }
+
+    std::ofstream out{ path, std::ios::trunc };
+    if (!out.is_open()) return false;
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    out.setf(std::ios::fixed);
+    out.precision(3);
+
+    bool first = true;
+    auto separator = [&] {
+        if (!first) out << ",\n";
+        first = false;
+    };
+
+    for (std::size_t i = 0; i < buffers.size(); ++i) {
+        auto& buffer = *buffers[i];
+
+        separator();
+        out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer.id << ",\"args\":{\"name\":";
+        writeJsonString(out, names[i]);
+        out << "}}";
+
+        // copy first, the owner keeps recording while we read
+        auto end = buffer.written.load(std::memory_order_acquire);
+        auto begin = std::max({ end - std::min<std::uint64_t>(end, eventsPerThread), buffer.cleared.load() });
+
+        std::vector<Event> events;
+        for (auto e = begin; e < end; ++e) {
+            const auto& slot = buffer.events[e % eventsPerThread];
+            events.push_back(Event{ slot.name.load(std::memory_order_relaxed), slot.start.load(std::memory_order_relaxed), slot.end.load(std::memory_order_relaxed) });
+        }
+
+        // drop what may have been overwritten during the copy, including the slot of event
+        // overwritten - eventsPerThread that the owner may be writing right now. The fence
+        // keeps the copy loads above from moving below this load.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        auto overwritten = buffer.written.load(std::memory_order_relaxed);
+        auto firstValid = (overwritten >= eventsPerThread) ? overwritten - eventsPerThread + 1 : 0;
+
+        for (auto e = std::max(begin, firstValid); e < end; ++e) {
+            const auto& event = events[e - begin];
+
+            separator();
+            out << "{\"name\":";
+            writeJsonString(out, event.name);
+            out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer.id
+                << ",\"ts\":" << toMicros(event.start)
+                << ",\"dur\":" << static_cast<double>(event.end - event.start) / ticksPerMicro << "}";
+        }
+    }
+
+    out << "\n]}\n";
+    return static_cast<bool>(out);
+}
+
+auto Profiler::clear() -> void {
+    std::lock_guard lock{ registry().mutex };
+    for (auto& buffer : registry().buffers) buffer->cleared = buffer->written.load();
+}
@@ -0,0 +1,286 @@
+#include "scramble_stats.h"
+
+#include <cmath>
+#include <thread>
+#include <iomanip>
+#include <ostream>
+#include <algorithm>
+
+
+namespace {
+
+// Breadth first search over one coordinate, distances in quarter turns
+template <int N>
+struct DistanceTable {
+    std::array<std::uint8_t, N> distance;
+
+    template <typename Get, typename Set>
+    DistanceTable(Get get, Set set) {
+        distance.fill(0xff);
+        distance[get(solvedCubieCube())] = 0;
+
+        std::vector<int> frontier{ get(solvedCubieCube()) };
+        std::vector<int> next;
+        for (std::uint8_t depth = 0; !frontier.empty(); ++depth) {
+            next.clear();
+            for (auto coord : frontier) {
+                auto cube = solvedCubieCube();
+                set(cube, coord);
+                for (int m = 0; m < moveCount; ++m) {
+                    auto moved = cube;
+                    applyMove(moved, static_cast<Move>(m));
+                    auto c = get(moved);
+                    if (distance[c] == 0xff) {
+                        distance[c] = depth + 1;
+                        next.push_back(c);
+                    }
+                }
+            }
+            frontier.swap(next);
+        }
+    }
+};
+
+struct DistanceTables {
+    DistanceTable<cornerOrientCoordCount> cornerOrient{ cornerOrientCoord, setCornerOrientCoord };
+    DistanceTable<edgeOrientCoordCount> edgeOrient{ edgeOrientCoord, setEdgeOrientCoord };
+    DistanceTable<cornerPermCoordCount> cornerPerm{ cornerPermCoord, setCornerPermCoord };
+};
+
+auto distanceTables() -> const DistanceTables& {
+    static const DistanceTables tables;
+    return tables;
+}
+
+// Regularized upper incomplete gamma function Q(a, x), Numerical Recipes style
+auto gammaQ(double a, double x) -> double {
+    if (x <= 0.0) return 1.0;
+
+    auto lnGammaA = std::lgamma(a);
+
+    if (x < a + 1.0) {
+        // series for P(a, x)
+        double sum = 1.0 / a;
+        double term = sum;
+        for (int n = 1; n < 1000; ++n) {
+            term *= x / (a + n);
+            sum += term;
+            if (std::abs(term) < std::abs(sum) * 1e-15) break;
+        }
+        return 1.0 - sum * std::exp(-x + a * std::log(x) - lnGammaA);
+    }
+
+    // continued fraction for Q(a, x)
+    const double tiny = 1e-300;
+    double b = x + 1.0 - a;
+    double c = 1.0 / tiny;
+    double d = 1.0 / b;
+    double h = d;
+    for (int i = 1; i < 1000; ++i) {
+        double an = -i * (i - a);
+        b += 2.0;
+        d = an * d + b;
+        if (std::abs(d) < tiny) d = tiny;
+        c = b + an / c;
+        if (std::abs(c) < tiny) c = tiny;
+        d = 1.0 / d;
+        double delta = d * c;
+        h *= delta;
+        if (std::abs(delta - 1.0) < 1e-15) break;
+    }
+    return std::exp(-x + a * std::log(x) - lnGammaA) * h;
+}
+
+auto randomMove(std::mt19937_64& rng) -> Move {
+    return static_cast<Move>(std::uniform_int_distribution<int>(0, moveCount - 1)(rng));
+}
+
+} // namespace
+
+
+auto shuffleGenerator(int steps) -> ScrambleGenerator {
+    // axis, side and direction uniform and independent is a uniform choice over all 12 turns
+    return [steps](std::mt19937_64& rng, std::vector<Move>& moves) {
+        moves.clear();
+        for (int i = 0; i < steps; ++i) moves.push_back(randomMove(rng));
+    };
+}
+
+auto noRepeatGenerator(int steps) -> ScrambleGenerator {
+    return [steps](std::mt19937_64& rng, std::vector<Move>& moves) {
+        moves.clear();
+        while (static_cast<int>(moves.size()) < steps) {
+            auto move = randomMove(rng);
+            if (!moves.empty() && static_cast<int>(moves.back()) / 2 == static_cast<int>(move) / 2) continue;
+            moves.push_back(move);
+        }
+    };
+}
+
+auto distanceLowerBound(const CubieCube& cube) -> int {
+    const auto& t = distanceTables();
+
+    int bound = t.cornerOrient.distance[cornerOrientCoord(cube)];
+    bound = std::max<int>(bound, t.edgeOrient.distance[edgeOrientCoord(cube)]);
+    bound = std::max<int>(bound, t.cornerPerm.distance[cornerPermCoord(cube)]);
+
+    int edgesOff = 0;
+    for (int i = 0; i < edgeCount; ++i) {
+        if (cube.edgePerm[i] != i || cube.edgeOrient[i] != 0) ++edgesOff;
+    }
+
+    return std::max(bound, (edgesOff + 3) / 4);
+}
+
+auto ScrambleAccumulator::add(const CubieCube& cube) -> void {
+    ++samples;
+
+    for (int slot = 0; slot < cornerCount; ++slot) {
+        auto piece = cube.cornerPerm[slot];
+        ++cornerPosition[piece][slot];
+        ++cornerOrientation[piece][cube.cornerOrient[slot]];
+    }
+
+    for (int slot = 0; slot < edgeCount; ++slot) {
+        auto piece = cube.edgePerm[slot];
+        ++edgePosition[piece][slot];
+        ++edgeOrientation[piece][cube.edgeOrient[slot]];
+    }
+
+    auto d = distanceLowerBound(cube);
+    if (d == 0) ++solved;
+    ++distance[std::min(d, maxDistance)];
+}
+
+auto ScrambleAccumulator::merge(const ScrambleAccumulator& other) -> void {
+    samples += other.samples;
+    solved += other.solved;
+
+    for (int p = 0; p < cornerCount; ++p) {
+        for (int s = 0; s < cornerCount; ++s) cornerPosition[p][s] += other.cornerPosition[p][s];
+        for (int o = 0; o < 3; ++o) cornerOrientation[p][o] += other.cornerOrientation[p][o];
+    }
+
+    for (int p = 0; p < edgeCount; ++p) {
+        for (int s = 0; s < edgeCount; ++s) edgePosition[p][s] += other.edgePosition[p][s];
+        for (int o = 0; o < 2; ++o) edgeOrientation[p][o] += other.edgeOrientation[p][o];
+    }
+
+    for (int d = 0; d <= maxDistance; ++d) distance[d] += other.distance[d];
+}
+
+auto chiSquareUniform(const std::uint64_t* counts, int n) -> ChiSquare {
+    double total = 0.0;
+    for (int i = 0; i < n; ++i) total += static_cast<double>(counts[i]);
+
+    double expected = total / n;
+    double statistic = 0.0;
+    if (expected > 0.0) {
+        for (int i = 0; i < n; ++i) {
+            double diff = static_cast<double>(counts[i]) - expected;
+            statistic += diff * diff / expected;
+        }
+    }
+
+    int dof = n - 1;
+    return ChiSquare{
+        .statistic = statistic,
+        .degreesOfFreedom = dof,
+        .pValue = gammaQ(dof / 2.0, statistic / 2.0)
+    };
+}
+
+ScrambleStats::ScrambleStats(ScrambleGenerator generator, ScrambleStatsConfig config) :
+    m_generator{ std::move(generator) },
+    m_config{ config },
+    m_result{},
+    m_threadsUsed{ 0 }
+{
+}
+
+auto ScrambleStats::run() -> const ScrambleAccumulator& {
+    auto threads = m_config.threads;
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = static_cast<unsigned int>(std::min<std::uint64_t>(threads, std::max<std::uint64_t>(m_config.scrambles, 1)));
+    m_threadsUsed = threads;
+
+    // build the lookup tables once before the workers race for them
+    distanceTables();
+
+    std::vector<ScrambleAccumulator> accumulators(threads);
+    std::vector<std::thread> workers;
+
+    for (unsigned int t = 0; t < threads; ++t) {
+        auto begin = m_config.scrambles * t / threads;
+        auto end = m_config.scrambles * (t + 1) / threads;
+
+        workers.emplace_back([this, t, begin, end, &accumulators]() {
+            auto& acc = accumulators[t];
+            std::mt19937_64 rng{ m_config.seed * 0x9e3779b97f4a7c15ull + t };
+            std::vector<Move> moves;
+
+            for (auto i = begin; i < end; ++i) {
+                m_generator(rng, moves);
+
+                auto cube = solvedCubieCube();
+                for (auto move : moves) applyMove(cube, move);
+                acc.add(cube);
+            }
+        });
+    }
+
+    for (auto& worker : workers) worker.join();
+
+    m_result = ScrambleAccumulator{};
+    for (const auto& acc : accumulators) m_result.merge(acc);
+
+    return m_result;
+}
+
+auto ScrambleStats::report(std::ostream& out) const -> void {
+    const auto& r = m_result;
+
+    out << "scrambles: " << r.samples << " (" << m_threadsUsed << " threads)\n";
+    out << "solved after scramble: " << r.solved << "\n";
+
+    // A position table has fixed row and column sums, every piece is in one slot and every
+    // slot holds one piece, so the summed statistic has (n - 1)^2 degrees of freedom
+    auto printTests = [&out](const char* name, const auto& table, int pieces, bool positions) {
+        double worstP = 1.0;
+        int worstPiece = 0;
+        double sum = 0.0;
+        int dof = 0;
+
+        for (int p = 0; p < pieces; ++p) {
+            auto test = chiSquareUniform(table[p].data(), static_cast<int>(table[p].size()));
+            sum += test.statistic;
+            dof += test.degreesOfFreedom;
+            if (test.pValue < worstP) {
+                worstP = test.pValue;
+                worstPiece = p;
+            }
+        }
+        if (positions) dof = (pieces - 1) * (pieces - 1);
+
+        out << std::left << std::setw(20) << name
+            << " chi2 = " << std::setw(12) << sum
+            << " dof = " << std::setw(4) << dof
+            << " p = " << std::setw(12) << gammaQ(dof / 2.0, sum / 2.0)
+            << " worst piece " << worstPiece << " (p = " << worstP << ")\n";
+    };
+
+    out << "\nuniformity (chi-square, per piece summed):\n";
+    printTests("corner position", r.cornerPosition, cornerCount, true);
+    printTests("corner orientation", r.cornerOrientation, cornerCount, false);
+    printTests("edge position", r.edgePosition, edgeCount, true);
+    printTests("edge orientation", r.edgeOrientation, edgeCount, false);
+
+    out << "\ndistance lower bound (quarter turns):\n";
+    double mean = 0.0;
+    for (int d = 0; d <= ScrambleAccumulator::maxDistance; ++d) {
+        if (r.distance[d] == 0) continue;
+        mean += d * static_cast<double>(r.distance[d]);
+        out << "  " << std::right << std::setw(2) << d << ": " << r.distance[d] << "\n";
+    }
+    if (r.samples > 0) out << "  mean: " << mean / r.samples << "\n";
+}
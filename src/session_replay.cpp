@@ -0,0 +1,232 @@
+#include "session_replay.h"
+
+#include <cmath>
+#include <chrono>
+#include <random>
+#include <algorithm>
+
+
+namespace {
+
+auto faceletDifferences(const CubeState& a, const CubeState& b) -> int {
+    int count = 0;
+    for (int i = 0; i < faceletCount; ++i) {
+        if (faceletColor(a, i) != faceletColor(b, i)) ++count;
+    }
+    return count;
+}
+
+class Replay {
+public:
+    explicit Replay(const ReplayConfig& config) :
+        m_config{ config },
+        m_cube{ config.rotationSpeed, config.cubeSpacing, 0 },
+        m_reference{ solvedCubeState() },
+        m_report{}
+    {
+        m_cube.init();
+    }
+
+    auto run(const SessionTrace& trace) -> ReplayReport {
+        auto start = std::chrono::steady_clock::now();
+        const auto& events = trace.events();
+
+        for (std::size_t i = 0; i < events.size(); ++i) {
+            const auto& event = events[i];
+
+            switch (event.type) {
+            case TraceEvent::Type::FRAME:
+                for (std::uint32_t n = 0; n < event.repeat; ++n) frame(i, event.deltaTime);
+                break;
+            case TraceEvent::Type::TURN: {
+                auto cfg = RubiksCube::toRotationConfig(event.move);
+                cfg.record = event.record;
+                cfg.speed = event.speed;
+                m_cube.addMove(cfg);
+                applyMove(m_reference, event.move);
+                ++m_report.turns;
+                break;
+            }
+            case TraceEvent::Type::PAUSE:
+                m_cube.addMove(RubiksCube::RotationConfig{ .axis = glm::vec3(0.0f), .side = 0, .direction = 0, .pause = event.deltaTime });
+                break;
+            case TraceEvent::Type::STATE:
+                m_cube.setCubeState(event.state);
+                m_reference = event.state;
+                break;
+            case TraceEvent::Type::SETTLE: {
+                std::uint64_t frames = 0;
+                while (m_cube.isBusy() && frames < m_config.settleFrameLimit) {
+                    frame(i, event.deltaTime);
+                    ++frames;
+                }
+                if (m_cube.isBusy()) fail(ReplayFailure::Kind::SETTLE, i, 0, 0.0f);
+                break;
+            }
+            case TraceEvent::Type::CHECK:
+                checkpoint(i, &event.state);
+                break;
+            }
+        }
+
+        checkpoint(events.size(), nullptr);
+
+        m_report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return m_report;
+    }
+
+private:
+    auto frame(std::size_t event, float deltaTime) -> void {
+        bool busy = m_cube.isBusy();
+        m_cube.update(deltaTime);
+
+        ++m_report.frames;
+        m_report.simulatedSeconds += deltaTime;
+
+        if (busy && !m_cube.isBusy()) checkpoint(event, nullptr);
+    }
+
+    auto checkpoint(std::size_t event, const CubeState* golden) -> void {
+        ++m_report.checkpoints;
+        const auto& state = m_cube.getCubeState();
+
+        if (golden) {
+            auto differences = faceletDifferences(state, *golden);
+            if (differences > 0) fail(ReplayFailure::Kind::GOLDEN, event, differences, 0.0f);
+        }
+
+        // the reference already holds every queued turn, so it only applies at rest
+        if (!m_cube.isBusy()) {
+            auto differences = faceletDifferences(state, m_reference);
+            if (differences > 0) fail(ReplayFailure::Kind::REFERENCE, event, differences, 0.0f);
+        }
+
+        // cubie matrices only change when a turn completes, so they match m_state at any frame
+        auto differences = faceletDifferences(m_cube.recomputeCubeState(), state);
+        if (differences > 0) fail(ReplayFailure::Kind::MISCLASSIFIED, event, differences, 0.0f);
+
+        auto drift = cubeDrift(m_cube, m_config.cubeSpacing);
+        m_report.maxDrift = std::max(m_report.maxDrift, drift);
+        if (drift > m_config.driftTolerance) fail(ReplayFailure::Kind::DRIFT, event, 0, drift);
+    }
+
+    auto fail(ReplayFailure::Kind kind, std::size_t event, int facelets, float drift) -> void {
+        ++m_report.failureCount;
+        if (m_report.failures.size() < m_config.maxReportedFailures) {
+            m_report.failures.push_back(ReplayFailure{ kind, event, m_report.frames, facelets, drift });
+        }
+    }
+
+    ReplayConfig m_config;
+    RubiksCube m_cube;
+    CubeState m_reference;
+    ReplayReport m_report;
+};
+
+} // namespace
+
+
+auto replaySession(const SessionTrace& trace, const ReplayConfig& config) -> ReplayReport {
+    Replay replay(config);
+    return replay.run(trace);
+}
+
+auto cubeDrift(const RubiksCube& cube, float cubeSpacing) -> float {
+    float drift = 0.0f;
+
+    for (const auto& c : cube.cubes()) {
+        for (int col = 0; col < 3; ++col) {
+            for (int row = 0; row < 3; ++row) {
+                auto v = c.model[col][row];
+                drift = std::max(drift, std::abs(v - std::round(v)));
+            }
+        }
+        for (int i = 0; i < 3; ++i) {
+            auto p = c.model[3][i] / cubeSpacing;
+            drift = std::max(drift, std::abs(p - std::round(p)) * cubeSpacing);
+        }
+    }
+
+    return drift;
+}
+
+auto replayFailureName(ReplayFailure::Kind kind) -> const char* {
+    switch (kind) {
+    case ReplayFailure::Kind::GOLDEN: return "golden";
+    case ReplayFailure::Kind::REFERENCE: return "reference";
+    case ReplayFailure::Kind::MISCLASSIFIED: return "misclassified";
+    case ReplayFailure::Kind::DRIFT: return "drift";
+    case ReplayFailure::Kind::SETTLE: return "settle";
+    default: return "unknown";
+    }
+}
+
+auto randomSessionTrace(std::size_t turns, std::uint64_t seed) -> SessionTrace {
+    std::mt19937_64 rng(seed);
+    auto uniform = [&](int lo, int hi) { return std::uniform_int_distribution<int>(lo, hi)(rng); };
+
+    // vsync rates, an uncapped jittery rate and the odd hitch that completes a turn in one frame
+    auto frameTime = [&]() -> float {
+        switch (uniform(0, 9)) {
+        case 0: return 1.0f / 30.0f;
+        case 1: case 2: return 1.0f / 144.0f;
+        case 3: return std::uniform_real_distribution<float>(0.0005f, 0.05f)(rng);
+        case 4: return (uniform(0, 19) == 0) ? 0.5f : 1.0f / 60.0f;
+        default: return 1.0f / 60.0f;
+        }
+    };
+
+    SessionTrace trace;
+    auto state = solvedCubeState();
+    std::vector<Move> history;
+    std::size_t queued = 0;
+
+    while (queued < turns) {
+        auto action = uniform(0, 19);
+
+        if (action == 0) {
+            // jump to a random position like a seek through the history, which waits for the cube to rest
+            trace.addSettle(frameTime());
+
+            auto jump = solvedCubeState();
+            for (int i = 0; i < 30; ++i) applyMove(jump, static_cast<Move>(uniform(0, moveCount - 1)));
+            trace.addState(jump);
+            state = jump;
+            history.clear();
+        }
+        else if (action == 1 && !history.empty()) {
+            // undo turns skip the history
+            auto move = inverseMove(history.back());
+            history.pop_back();
+            trace.addTurn(move, false);
+            applyMove(state, move);
+            ++queued;
+        }
+        else {
+            // hand turns or a shuffle at the faster queued speed
+            auto burst = uniform(1, 12);
+            auto speed = (uniform(0, 1) == 0) ? 0.0f : RubiksCube::queuedRotationSpeed;
+            for (int i = 0; i < burst; ++i) {
+                auto move = static_cast<Move>(uniform(0, moveCount - 1));
+                trace.addTurn(move, true, speed);
+                applyMove(state, move);
+                history.push_back(move);
+                ++queued;
+            }
+            if (uniform(0, 4) == 0) trace.addPause(0.25f);
+        }
+
+        // frames while the turns animate, often not enough to finish them
+        auto frames = uniform(0, 40);
+        for (int i = 0; i < frames; ++i) trace.addFrame(frameTime());
+
+        if (uniform(0, 3) == 0) {
+            trace.addSettle(frameTime());
+            trace.addCheck(state);
+        }
+    }
+
+    trace.addSettle(1.0f / 60.0f);
+    trace.addCheck(state);
+    return trace;
+}
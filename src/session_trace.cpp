@@ -0,0 +1,163 @@
+#include "session_trace.h"
+
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <stdexcept>
+
+
+namespace {
+
+auto parseEvent(const std::string& type, std::istringstream& in) -> TraceEvent {
+    auto event = TraceEvent{};
+    std::string value;
+
+    if (type == "frames") {
+        std::string count;
+        in >> count >> value;
+        event.type = TraceEvent::Type::FRAME;
+        event.repeat = static_cast<std::uint32_t>(std::stoul(count));
+        event.deltaTime = std::stof(value);
+    }
+    else if (type == "turn") {
+        in >> value;
+
+        auto moves = movesFromString(value);
+        if (moves.size() != 1) throw std::runtime_error("a turn is one quarter turn: " + value);
+
+        event.type = TraceEvent::Type::TURN;
+        event.move = moves[0];
+
+        std::string flag;
+        while (in >> flag) {
+            if (flag == "norecord") {
+                event.record = false;
+            }
+            else if (flag == "speed") {
+                if (!(in >> value)) throw std::runtime_error("missing turn speed");
+                event.speed = std::stof(value);
+            }
+            else {
+                throw std::runtime_error("unknown turn flag: " + flag);
+            }
+        }
+    }
+    else if (type == "pause" || type == "settle") {
+        in >> value;
+        event.type = (type == "pause") ? TraceEvent::Type::PAUSE : TraceEvent::Type::SETTLE;
+        event.deltaTime = std::stof(value);
+    }
+    else if (type == "state" || type == "check") {
+        in >> value;
+        event.type = (type == "state") ? TraceEvent::Type::STATE : TraceEvent::Type::CHECK;
+        event.state = stateFromString(value);
+    }
+    else {
+        throw std::runtime_error("unknown event: " + type);
+    }
+
+    return event;
+}
+
+} // namespace
+
+
+auto SessionTrace::addFrame(float deltaTime) -> void {
+    // runs of equal frame times are common with vsync or a frame cap
+    if (!m_events.empty()) {
+        auto& last = m_events.back();
+        if (last.type == TraceEvent::Type::FRAME && last.deltaTime == deltaTime) {
+            ++last.repeat;
+            return;
+        }
+    }
+
+    m_events.push_back(TraceEvent{ .type = TraceEvent::Type::FRAME, .deltaTime = deltaTime });
+}
+
+auto SessionTrace::addTurn(Move move, bool record, float speed) -> void {
+    m_events.push_back(TraceEvent{ .type = TraceEvent::Type::TURN, .move = move, .record = record, .speed = speed });
+}
+
+auto SessionTrace::addPause(float seconds) -> void {
+    m_events.push_back(TraceEvent{ .type = TraceEvent::Type::PAUSE, .deltaTime = seconds });
+}
+
+auto SessionTrace::addState(const CubeState& state) -> void {
+    m_events.push_back(TraceEvent{ .type = TraceEvent::Type::STATE, .state = state });
+}
+
+auto SessionTrace::addSettle(float deltaTime) -> void {
+    m_events.push_back(TraceEvent{ .type = TraceEvent::Type::SETTLE, .deltaTime = deltaTime });
+}
+
+auto SessionTrace::addCheck(const CubeState& state) -> void {
+    m_events.push_back(TraceEvent{ .type = TraceEvent::Type::CHECK, .state = state });
+}
+
+auto SessionTrace::load(const std::filesystem::path& path) -> SessionTrace {
+    std::ifstream file{ path };
+    if (!file.is_open()) throw std::runtime_error("could not open session trace: " + path.string());
+
+    SessionTrace trace;
+    std::string line;
+    int lineNumber = 0;
+
+    while (std::getline(file, line)) {
+        ++lineNumber;
+
+        auto comment = line.find('#');
+        if (comment != std::string::npos) line.erase(comment);
+
+        std::istringstream in{ line };
+        std::string type;
+        if (!(in >> type)) continue;
+
+        try {
+            trace.m_events.push_back(parseEvent(type, in));
+        }
+        catch (const std::exception& e) {
+            // std::stof and std::stoul throw logic errors on malformed numbers
+            throw std::runtime_error(path.string() + ":" + std::to_string(lineNumber) + ": " + e.what());
+        }
+    }
+
+    return trace;
+}
+
+auto SessionTrace::save(const std::filesystem::path& path) const -> bool {
+    std::ofstream file{ path, std::ios::trunc };
+    if (!file.is_open()) return false;
+
+    // 9 significant digits read back as the same float, so replays see identical frame times
+    file << std::setprecision(9);
+    file << "# cube session trace\n";
+
+    for (const auto& event : m_events) {
+        switch (event.type) {
+        case TraceEvent::Type::FRAME:
+            file << "frames " << event.repeat << " " << event.deltaTime << "\n";
+            break;
+        case TraceEvent::Type::TURN:
+            file << "turn " << moveToString(event.move) << (event.record ? "" : " norecord");
+            if (event.speed > 0.0f) file << " speed " << event.speed;
+            file << "\n";
+            break;
+        case TraceEvent::Type::PAUSE:
+            file << "pause " << event.deltaTime << "\n";
+            break;
+        case TraceEvent::Type::STATE:
+            file << "state " << stateToString(event.state) << "\n";
+            break;
+        case TraceEvent::Type::SETTLE:
+            file << "settle " << event.deltaTime << "\n";
+            break;
+        case TraceEvent::Type::CHECK:
+            file << "check " << stateToString(event.state) << "\n";
+            break;
+        }
+    }
+
+    return static_cast<bool>(file);
+}
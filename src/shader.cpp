@@ -4,6 +4,57 @@
 
 #include <glm/gtc/type_ptr.hpp>
 
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <iterator>
+
+
+namespace {
+
+constexpr char binaryMagic[8] = { 'C', 'U', 'B', 'E', 'P', 'R', 'O', 'G' };
+
+// FNV-1a, only used to tell cache entries apart
+std::uint64_t hashBytes(std::uint64_t hash, std::string_view bytes)
+{
+    for (auto c : bytes) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+std::string_view glString(GLenum name)
+{
+    auto str = reinterpret_cast<const char*>(glGetString(name));
+    return str ? std::string_view{ str } : std::string_view{};
+}
+
+unsigned int compileStage(GLenum type, std::string_view source, const char* stageName)
+{
+    unsigned int handle = glCreateShader(type);
+    int success;
+    char infoLog[512];
+
+    const char* sourcePtr = source.data();
+    int sourceLength = static_cast<int>(source.size());
+    glShaderSource(handle, 1, &sourcePtr, &sourceLength);
+    glCompileShader(handle);
+
+    glGetShaderiv(handle, GL_COMPILE_STATUS, &success);
+    if (!success) {
+        glGetShaderInfoLog(handle, 512, nullptr, infoLog);
+        std::cout << "ERROR::SHADER::" << stageName << "::COMPILATION_FAILED\n" << infoLog << "\n";
+
+        glDeleteShader(handle);
+        throw std::runtime_error(std::string(stageName) + " shader could not be compiled!");
+    }
+
+    return handle;
+}
+
+} // namespace
+
 
 Shader::Shader(const std::filesystem::path& vertexPath, const std::filesystem::path& fragmentPath)
 {
@@ -13,40 +64,57 @@ Shader::Shader(const std::filesystem::path& vertexPath, const std::filesystem::p
     if (vertexShaderSourceStr.empty()) throw std::runtime_error("vertexShaderSourceStr is empty!");
     if (fragmentShaderSourceStr.empty()) throw std::runtime_error("fragmentShaderSourceStr is empty!");
 
-    // Vertex shader
-    unsigned int vertexShaderHandle = glCreateShader(GL_VERTEX_SHADER);
-    int vertexShaderSuccess;
-    char vertexShaderInfoLog[512];
-
-    const char* vertexShaderSource = vertexShaderSourceStr.c_str();
-    glShaderSource(vertexShaderHandle, 1, &vertexShaderSource, nullptr);
-    glCompileShader(vertexShaderHandle);
+    compile(vertexShaderSourceStr, fragmentShaderSourceStr, false);
+}
 
-    glGetShaderiv(vertexShaderHandle, GL_COMPILE_STATUS, &vertexShaderSuccess);
-    if (!vertexShaderSuccess) {
-        glGetShaderInfoLog(vertexShaderHandle, 512, nullptr, vertexShaderInfoLog);
-        std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << vertexShaderInfoLog << "\n";
+Shader::Shader(const ShaderSource& source, const std::filesystem::path& cacheDirectory)
+{
+    if (cacheDirectory.empty()) {
+        compile(source.vertex, source.fragment, false);
+        return;
+    }
 
-        glDeleteShader(vertexShaderHandle);
-        throw std::runtime_error("vertex shader could not be compiled!");
+    // program binaries are only valid for the exact driver that produced them
+    std::uint64_t key = 0xcbf29ce484222325ull;
+    for (auto name : { GL_VENDOR, GL_RENDERER, GL_VERSION, GL_SHADING_LANGUAGE_VERSION }) {
+        key = hashBytes(key, glString(name));
+        key = hashBytes(key, std::string_view{ "\0", 1 });
+    }
+    key = hashBytes(key, source.vertex);
+    key = hashBytes(key, std::string_view{ "\0", 1 });
+    key = hashBytes(key, source.fragment);
+
+    char keyHex[17];
+    std::snprintf(keyHex, sizeof(keyHex), "%016llx", static_cast<unsigned long long>(key));
+    auto path = cacheDirectory / (std::string(source.name) + "-" + keyHex + ".bin");
+
+    int formatCount = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+    if (formatCount == 0) {
+        compile(source.vertex, source.fragment, false);
+        return;
     }
 
-    // Fragment shader
-    unsigned int fragmentShaderHandle = glCreateShader(GL_FRAGMENT_SHADER);
-    int fragmentShaderSuccess;
-    char fragmentShaderInfoLog[512];
+    if (loadBinary(path, key)) {
+        loadedFromCache = true;
+        return;
+    }
 
-    const char* fragmentShaderSource = fragmentShaderSourceStr.c_str();
-    glShaderSource(fragmentShaderHandle, 1, &fragmentShaderSource, nullptr);
-    glCompileShader(fragmentShaderHandle);
+    compile(source.vertex, source.fragment, true);
+    storeBinary(path, key);
+}
 
-    glGetShaderiv(fragmentShaderHandle, GL_COMPILE_STATUS, &fragmentShaderSuccess);
-    if (!fragmentShaderSuccess) {
-        glGetShaderInfoLog(fragmentShaderHandle, 512, nullptr, fragmentShaderInfoLog);
-        std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << fragmentShaderInfoLog << "\n";
+void Shader::compile(std::string_view vertexSource, std::string_view fragmentSource, bool retrievable)
+{
+    unsigned int vertexShaderHandle = compileStage(GL_VERTEX_SHADER, vertexSource, "VERTEX");
 
-        glDeleteShader(fragmentShaderHandle);
-        throw std::runtime_error("fragment shader could not be compiled!");
+    unsigned int fragmentShaderHandle;
+    try {
+        fragmentShaderHandle = compileStage(GL_FRAGMENT_SHADER, fragmentSource, "FRAGMENT");
+    }
+    catch (...) {
+        glDeleteShader(vertexShaderHandle);
+        throw;
     }
 
     // Create shader program
@@ -54,6 +122,7 @@ Shader::Shader(const std::filesystem::path& vertexPath, const std::filesystem::p
     char programInfoLog[512];
 
     ID = glCreateProgram();
+    if (retrievable) glProgramParameteri(ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
     glAttachShader(ID, vertexShaderHandle);
     glAttachShader(ID, fragmentShaderHandle);
     glLinkProgram(ID);
@@ -72,6 +141,78 @@ Shader::Shader(const std::filesystem::path& vertexPath, const std::filesystem::p
     glDeleteShader(fragmentShaderHandle);
 }
 
+// Cache file: magic, u64 key, u32 binary format, program binary
+bool Shader::loadBinary(const std::filesystem::path& path, std::uint64_t key)
+{
+    std::ifstream file{ path, std::ios::binary };
+    if (!file.is_open()) return false;
+
+    char magic[sizeof(binaryMagic)];
+    std::uint64_t fileKey = 0;
+    std::uint32_t format = 0;
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char*>(&fileKey), sizeof(fileKey));
+    file.read(reinterpret_cast<char*>(&format), sizeof(format));
+    if (!file || std::memcmp(magic, binaryMagic, sizeof(magic)) != 0 || fileKey != key) return false;
+
+    std::string binary{ std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+    if (binary.empty()) return false;
+
+    ID = glCreateProgram();
+    glProgramBinary(ID, format, binary.data(), static_cast<GLsizei>(binary.size()));
+
+    // drivers may still reject a binary, e.g. after an update that kept the version string
+    int success = 0;
+    glGetProgramiv(ID, GL_LINK_STATUS, &success);
+    if (!success) {
+        glDeleteProgram(ID);
+        ID = 0;
+        return false;
+    }
+
+    return true;
+}
+
+void Shader::storeBinary(const std::filesystem::path& path, std::uint64_t key) const
+{
+    int length = 0;
+    glGetProgramiv(ID, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) return;
+
+    std::string binary(static_cast<std::size_t>(length), '\0');
+    GLenum format = 0;
+    glGetProgramBinary(ID, length, &length, &format, binary.data());
+    binary.resize(static_cast<std::size_t>(length));
+
+    // a failing cache only costs the next start its compile time
+    std::error_code error;
+    std::filesystem::create_directories(path.parent_path(), error);
+
+    // write next to the target and rename, so concurrent starts never read a half written file
+    auto tempPath = path;
+    tempPath += ".tmp" + std::to_string(std::random_device{}());
+    {
+        std::ofstream file{ tempPath, std::ios::binary | std::ios::trunc };
+        if (!file.is_open()) return;
+
+        auto format32 = static_cast<std::uint32_t>(format);
+        file.write(binaryMagic, sizeof(binaryMagic));
+        file.write(reinterpret_cast<const char*>(&key), sizeof(key));
+        file.write(reinterpret_cast<const char*>(&format32), sizeof(format32));
+        file.write(binary.data(), static_cast<std::streamsize>(binary.size()));
+
+        // closing flushes, so a full disk shows up here as well
+        file.close();
+        if (!file) {
+            std::filesystem::remove(tempPath, error);
+            return;
+        }
+    }
+
+    std::filesystem::rename(tempPath, path, error);
+    if (error) std::filesystem::remove(tempPath, error);
+}
+
 void Shader::use()
 {
     glUseProgram(ID);
@@ -0,0 +1,322 @@
+#include "solve_protocol.h"
+
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "user_cache.h"
+
+
+namespace {
+
+class ByteWriter {
+public:
+    explicit ByteWriter(std::vector<std::uint8_t>& out) : m_out{ out } {}
+
+    template <typename T>
+    auto put(T value) -> void {
+        for (std::size_t i = 0; i < sizeof(T); ++i) m_out.push_back(static_cast<std::uint8_t>(static_cast<std::uint64_t>(value) >> (8 * i)));
+    }
+
+    auto bytes(const void* data, std::size_t size) -> void {
+        auto p = static_cast<const std::uint8_t*>(data);
+        m_out.insert(m_out.end(), p, p + size);
+    }
+
+private:
+    std::vector<std::uint8_t>& m_out;
+};
+
+// Reads past the end set a sticky error flag instead of throwing
+class ByteReader {
+public:
+    explicit ByteReader(const std::vector<std::uint8_t>& in) : m_in{ in }, m_pos{ 0 }, m_ok{ true } {}
+
+    template <typename T>
+    auto get() -> T {
+        if (!has(sizeof(T))) return T{};
+
+        std::uint64_t value = 0;
+        for (std::size_t i = 0; i < sizeof(T); ++i) value |= static_cast<std::uint64_t>(m_in[m_pos++]) << (8 * i);
+        return static_cast<T>(value);
+    }
+
+    auto bytes(void* data, std::size_t size) -> void {
+        if (!has(size)) return;
+        std::memcpy(data, m_in.data() + m_pos, size);
+        m_pos += size;
+    }
+
+    // true if everything read so far was present and nothing is left over
+    auto done() const -> bool { return m_ok && m_pos == m_in.size(); }
+    auto ok() const -> bool { return m_ok; }
+
+private:
+    auto has(std::size_t size) -> bool {
+        if (m_pos + size > m_in.size()) m_ok = false;
+        return m_ok;
+    }
+
+    const std::vector<std::uint8_t>& m_in;
+    std::size_t m_pos;
+    bool m_ok;
+};
+
+auto readMoves(ByteReader& in, std::size_t count, std::vector<Move>& moves) -> bool {
+    for (std::size_t i = 0; i < count; ++i) {
+        auto m = in.get<std::uint8_t>();
+        if (m >= moveCount) return false;
+        moves.push_back(static_cast<Move>(m));
+    }
+    return in.ok();
+}
+
+// counters in wire order
+auto statsFields(SolveStats& s) -> std::vector<std::uint64_t*> {
+    return {
+        &s.uptimeMillis, &s.connections, &s.requests, &s.solved, &s.failed, &s.badRequests,
+        &s.batches, &s.latencyMeanMicros, &s.latencyP50Micros, &s.latencyP99Micros, &s.latencyMaxMicros,
+        &s.overloaded
+    };
+}
+
+} // namespace
+
+
+auto defaultSolveSocket() -> std::string {
+    auto directory = userRuntimeDirectory("rubiks_solve");
+    if (directory.empty()) return {};
+    return (directory / "solve.sock").string();
+}
+
+auto encodeRequest(const SolveRequest& request) -> SolveFrame {
+    auto frame = SolveFrame{ request.state ? SolveMessage::SOLVE_STATE : SolveMessage::SOLVE_MOVES, request.id, {} };
+    ByteWriter out{ frame.payload };
+
+    out.put(static_cast<std::uint8_t>(request.solver));
+    if (request.state) {
+        out.bytes(request.state->data(), request.state->size());
+    }
+    else {
+        if (request.scramble.size() > maxScrambleLength) throw std::runtime_error("scramble is too long!");
+        out.put(static_cast<std::uint16_t>(request.scramble.size()));
+        for (auto m : request.scramble) out.put(static_cast<std::uint8_t>(m));
+    }
+
+    return frame;
+}
+
+auto decodeRequest(const SolveFrame& frame) -> std::optional<SolveRequest> {
+    if (frame.type != SolveMessage::SOLVE_MOVES && frame.type != SolveMessage::SOLVE_STATE) return std::nullopt;
+
+    auto request = SolveRequest{ .id = frame.id, .solver = SolverKind::CFOP, .scramble = {}, .state = std::nullopt };
+    ByteReader in{ frame.payload };
+
+    auto solver = in.get<std::uint8_t>();
+    if (solver > static_cast<std::uint8_t>(SolverKind::OPTIMAL)) return std::nullopt;
+    request.solver = static_cast<SolverKind>(solver);
+
+    if (frame.type == SolveMessage::SOLVE_STATE) {
+        request.state = PackedState{};
+        in.bytes(request.state->data(), request.state->size());
+    }
+    else {
+        auto count = in.get<std::uint16_t>();
+        if (count > maxScrambleLength || !readMoves(in, count, request.scramble)) return std::nullopt;
+    }
+
+    if (!in.done()) return std::nullopt;
+    return request;
+}
+
+auto encodeResponse(const SolveResponse& response) -> SolveFrame {
+    auto frame = SolveFrame{ SolveMessage::SOLUTION, response.id, {} };
+    ByteWriter out{ frame.payload };
+
+    out.put(static_cast<std::uint8_t>(response.status));
+    out.put(response.solveMicros);
+    out.put(static_cast<std::uint8_t>(response.stages.size()));
+
+    for (const auto& stage : response.stages) {
+        auto labelSize = std::min<std::size_t>(stage.label.size(), 255);
+        out.put(static_cast<std::uint8_t>(labelSize));
+        out.bytes(stage.label.data(), labelSize);
+        out.put(static_cast<std::uint16_t>(stage.moves.size()));
+        for (auto m : stage.moves) out.put(static_cast<std::uint8_t>(m));
+    }
+
+    return frame;
+}
+
+auto decodeResponse(const SolveFrame& frame) -> std::optional<SolveResponse> {
+    if (frame.type != SolveMessage::SOLUTION) return std::nullopt;
+
+    auto response = SolveResponse{ .id = frame.id, .status = SolveStatus::OK, .solveMicros = 0, .stages = {} };
+    ByteReader in{ frame.payload };
+
+    auto status = in.get<std::uint8_t>();
+    if (status > static_cast<std::uint8_t>(SolveStatus::REJECTED)) return std::nullopt;
+    response.status = static_cast<SolveStatus>(status);
+    response.solveMicros = in.get<std::uint32_t>();
+
+    auto stageCount = in.get<std::uint8_t>();
+    for (int i = 0; i < stageCount && in.ok(); ++i) {
+        auto& stage = response.stages.emplace_back();
+        stage.label.resize(in.get<std::uint8_t>());
+        in.bytes(stage.label.data(), stage.label.size());
+        if (!readMoves(in, in.get<std::uint16_t>(), stage.moves)) return std::nullopt;
+    }
+
+    if (!in.done()) return std::nullopt;
+    return response;
+}
+
+auto encodeStats(std::uint32_t id, const SolveStats& stats) -> SolveFrame {
+    auto frame = SolveFrame{ SolveMessage::STATS_REPLY, id, {} };
+    ByteWriter out{ frame.payload };
+
+    auto copy = stats;
+    auto fields = statsFields(copy);
+    out.put(static_cast<std::uint8_t>(fields.size()));
+    for (auto field : fields) out.put(*field);
+
+    return frame;
+}
+
+auto decodeStats(const SolveFrame& frame) -> std::optional<SolveStats> {
+    if (frame.type != SolveMessage::STATS_REPLY) return std::nullopt;
+
+    auto stats = SolveStats{};
+    ByteReader in{ frame.payload };
+
+    // newer daemons may append counters, older ones leave the rest at zero
+    auto count = in.get<std::uint8_t>();
+    auto fields = statsFields(stats);
+    for (std::size_t i = 0; i < count; ++i) {
+        auto value = in.get<std::uint64_t>();
+        if (i < fields.size()) *fields[i] = value;
+    }
+
+    if (!in.done()) return std::nullopt;
+    return stats;
+}
+
+auto appendFrame(std::vector<std::uint8_t>& out, const SolveFrame& frame) -> void {
+    ByteWriter writer{ out };
+    writer.put(static_cast<std::uint32_t>(1 + sizeof(frame.id) + frame.payload.size()));
+    writer.put(static_cast<std::uint8_t>(frame.type));
+    writer.put(frame.id);
+    writer.bytes(frame.payload.data(), frame.payload.size());
+}
+
+auto sendBytes(int fd, const std::vector<std::uint8_t>& bytes) -> bool {
+    std::size_t sent = 0;
+    while (sent < bytes.size()) {
+        // MSG_NOSIGNAL: a vanished peer is an error return, not SIGPIPE
+        auto n = ::send(fd, bytes.data() + sent, bytes.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) return false;
+        sent += static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+auto sendFrame(int fd, const SolveFrame& frame) -> bool {
+    std::vector<std::uint8_t> bytes;
+    appendFrame(bytes, frame);
+    return sendBytes(fd, bytes);
+}
+
+auto receiveFrame(int fd) -> std::optional<SolveFrame> {
+    auto readAll = [fd](void* data, std::size_t size) {
+        auto p = static_cast<std::uint8_t*>(data);
+        while (size > 0) {
+            auto n = ::recv(fd, p, size, 0);
+            if (n <= 0) return false;
+            p += n;
+            size -= static_cast<std::size_t>(n);
+        }
+        return true;
+    };
+
+    std::uint8_t head[9];
+    if (!readAll(head, sizeof(head))) return std::nullopt;
+
+    std::vector<std::uint8_t> headBytes(head, head + sizeof(head));
+    ByteReader in{ headBytes };
+    auto size = in.get<std::uint32_t>();
+    auto type = in.get<std::uint8_t>();
+    auto id = in.get<std::uint32_t>();
+
+    if (size < 5 || size > maxFrameSize) return std::nullopt;
+
+    auto frame = SolveFrame{ static_cast<SolveMessage>(type), id, std::vector<std::uint8_t>(size - 5) };
+    if (!readAll(frame.payload.data(), frame.payload.size())) return std::nullopt;
+    return frame;
+}
+
+SolveClient::SolveClient(const std::string& socketPath) :
+    m_fd{ -1 },
+    m_nextId{ 1 }
+{
+    auto address = sockaddr_un{};
+    address.sun_family = AF_UNIX;
+    if (socketPath.empty()) throw std::runtime_error("no private directory for the solve socket, pass --socket");
+    if (socketPath.size() >= sizeof(address.sun_path)) throw std::runtime_error("socket path is too long: " + socketPath);
+    std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+
+    m_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (m_fd < 0 || ::connect(m_fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+        if (m_fd >= 0) ::close(m_fd);
+        throw std::runtime_error("could not connect to solve daemon at " + socketPath);
+    }
+}
+
+SolveClient::~SolveClient() {
+    ::close(m_fd);
+}
+
+auto SolveClient::submit(const std::vector<Move>& scramble, SolverKind solver) -> std::uint32_t {
+    auto id = m_nextId++;
+    send(encodeRequest(SolveRequest{ .id = id, .solver = solver, .scramble = scramble, .state = std::nullopt }));
+    return id;
+}
+
+auto SolveClient::submit(const CubieCube& cube, SolverKind solver) -> std::uint32_t {
+    auto id = m_nextId++;
+    send(encodeRequest(SolveRequest{ .id = id, .solver = solver, .scramble = {}, .state = packState(cube) }));
+    return id;
+}
+
+auto SolveClient::receive() -> SolveResponse {
+    auto response = decodeResponse(receive(SolveMessage::SOLUTION));
+    if (!response) throw std::runtime_error("malformed solution from solve daemon!");
+    return *response;
+}
+
+auto SolveClient::solve(const std::vector<Move>& scramble, SolverKind solver) -> SolveResponse {
+    submit(scramble, solver);
+    return receive();
+}
+
+auto SolveClient::stats() -> SolveStats {
+    send(SolveFrame{ SolveMessage::STATS, m_nextId++, {} });
+
+    auto stats = decodeStats(receive(SolveMessage::STATS_REPLY));
+    if (!stats) throw std::runtime_error("malformed stats from solve daemon!");
+    return *stats;
+}
+
+auto SolveClient::send(const SolveFrame& frame) -> void {
+    if (!sendFrame(m_fd, frame)) throw std::runtime_error("lost connection to solve daemon!");
+}
+
+auto SolveClient::receive(SolveMessage type) -> SolveFrame {
+    auto frame = receiveFrame(m_fd);
+    if (!frame) throw std::runtime_error("lost connection to solve daemon!");
+    if (frame->type != type) throw std::runtime_error("unexpected message from solve daemon!");
+    return *frame;
+}
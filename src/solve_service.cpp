@@ -0,0 +1,435 @@
+#include "solve_service.h"
+
+#include <bit>
+#include <map>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+#include "bidirectional_solver.h"
+#include "profiler.h"
+
+
+namespace {
+
+auto micros(std::chrono::steady_clock::duration d) -> std::uint64_t {
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(d).count());
+}
+
+} // namespace
+
+
+// Closed once the last queued request of it is answered, so the fd cannot be reused under a worker
+struct SolveService::Connection {
+    int fd = -1;
+    std::size_t maxOutbox = 0;
+    std::atomic<bool> open = true;
+
+    std::mutex outboxMutex;
+    std::condition_variable outboxCondition;
+    std::vector<std::uint8_t> outbox;   // frames not handed to the socket yet
+    std::size_t unanswered = 0;         // queued requests, the writer waits for them after the reader is done
+    bool reading = true;
+    bool dropped = false;
+
+    ~Connection() { ::close(fd); }
+
+    // Queues frames for the writer thread and never blocks on the peer, answered counts the
+    // queued requests they settle. A connection whose outbox overflows is dropped.
+    auto post(const std::vector<std::uint8_t>& bytes, std::size_t answered) -> void {
+        std::lock_guard lock{ outboxMutex };
+        unanswered -= answered;
+        if (dropped) return;
+
+        if (outbox.size() + bytes.size() > maxOutbox) {
+            dropLocked();
+            return;
+        }
+        outbox.insert(outbox.end(), bytes.begin(), bytes.end());
+        outboxCondition.notify_one();
+    }
+
+    auto drop() -> void {
+        std::lock_guard lock{ outboxMutex };
+        dropLocked();
+    }
+
+    // shutdown wakes the reader without closing the fd under anyone
+    auto dropLocked() -> void {
+        dropped = true;
+        outbox.clear();
+        outbox.shrink_to_fit();
+        ::shutdown(fd, SHUT_RDWR);
+        outboxCondition.notify_one();
+    }
+};
+
+SolveService::SolveService(SolveServiceConfig config) :
+    m_config{ std::move(config) },
+    m_cfop{},
+    m_optimalMutex{},
+    m_listenFd{ -1 },
+    m_start{ std::chrono::steady_clock::now() },
+    m_queueMutex{},
+    m_pendingCondition{},
+    m_batchCondition{},
+    m_pending{},
+    m_batches{},
+    m_queued{ 0 },
+    m_workerCount{ 1 },
+    m_stopping{ false },
+    m_readers{},
+    m_dispatcher{},
+    m_workers{},
+    m_connections{ 0 },
+    m_requests{ 0 },
+    m_solved{ 0 },
+    m_failed{ 0 },
+    m_badRequests{ 0 },
+    m_overloaded{ 0 },
+    m_batchCount{ 0 },
+    m_latencyTotal{ 0 },
+    m_latencyMax{ 0 },
+    m_latencyBuckets{}
+{
+    auto address = sockaddr_un{};
+    address.sun_family = AF_UNIX;
+    if (m_config.socketPath.empty()) throw std::runtime_error("no private directory for the solve socket, pass --socket");
+    if (m_config.socketPath.size() >= sizeof(address.sun_path)) throw std::runtime_error("socket path is too long: " + m_config.socketPath);
+    std::memcpy(address.sun_path, m_config.socketPath.c_str(), m_config.socketPath.size() + 1);
+
+    // bind fails on a stale socket file from a previous daemon, but a socket that still
+    // accepts connections belongs to a running one
+    struct stat info{};
+    if (::lstat(m_config.socketPath.c_str(), &info) == 0) {
+        if (!S_ISSOCK(info.st_mode)) throw std::runtime_error(m_config.socketPath + " exists and is not a socket");
+
+        int probe = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        bool running = probe >= 0 && ::connect(probe, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0;
+        if (probe >= 0) ::close(probe);
+        if (running) throw std::runtime_error("a solve daemon is already listening on " + m_config.socketPath);
+
+        ::unlink(m_config.socketPath.c_str());
+    }
+
+    m_listenFd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (m_listenFd < 0 || ::bind(m_listenFd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+        if (m_listenFd >= 0) ::close(m_listenFd);
+        throw std::runtime_error("could not listen on " + m_config.socketPath);
+    }
+
+    // only this user may connect, even where --socket points into a shared directory,
+    // nobody can connect before listen
+    if (::chmod(m_config.socketPath.c_str(), 0600) != 0 || ::listen(m_listenFd, 64) != 0) {
+        ::close(m_listenFd);
+        ::unlink(m_config.socketPath.c_str());
+        throw std::runtime_error("could not listen on " + m_config.socketPath);
+    }
+}
+
+SolveService::~SolveService() {
+    ::close(m_listenFd);
+    ::unlink(m_config.socketPath.c_str());
+}
+
+auto SolveService::run(const std::atomic<bool>& stop) -> void {
+    m_workerCount = m_config.workers;
+    if (m_workerCount == 0) m_workerCount = std::max(1u, std::thread::hardware_concurrency());
+
+    m_stopping = false;
+    m_dispatcher = std::thread(&SolveService::dispatch, this);
+    for (unsigned int i = 0; i < m_workerCount; ++i) m_workers.emplace_back(&SolveService::work, this);
+
+    while (!stop) {
+        // wake up regularly to notice stop and to join readers of closed connections
+        auto fds = pollfd{ m_listenFd, POLLIN, 0 };
+        if (::poll(&fds, 1, 100) > 0 && (fds.revents & POLLIN)) {
+            int fd = ::accept(m_listenFd, nullptr, nullptr);
+            if (fd >= 0) {
+                // a send that makes no progress for this long fails and drops the connection
+                auto millis = m_config.sendTimeout.count();
+                auto timeout = timeval{ .tv_sec = static_cast<time_t>(millis / 1000), .tv_usec = static_cast<suseconds_t>((millis % 1000) * 1000) };
+                ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+                auto connection = std::make_shared<Connection>();
+                connection->fd = fd;
+                connection->maxOutbox = m_config.maxOutbox;
+                ++m_connections;
+                m_readers.emplace_back(connection, std::thread(&SolveService::readConnection, this, connection));
+            }
+        }
+
+        for (auto it = m_readers.begin(); it != m_readers.end();) {
+            if (it->first->open) {
+                ++it;
+                continue;
+            }
+            it->second.join();
+            it = m_readers.erase(it);
+        }
+    }
+
+    // unblock the readers and writers, then let the pool drain what was already queued
+    for (auto& [connection, thread] : m_readers) connection->drop();
+    for (auto& [connection, thread] : m_readers) thread.join();
+
+    {
+        std::lock_guard lock{ m_queueMutex };
+        m_stopping = true;
+    }
+    m_pendingCondition.notify_all();
+    m_batchCondition.notify_all();
+
+    m_dispatcher.join();
+    for (auto& worker : m_workers) worker.join();
+    m_workers.clear();
+    m_readers.clear();
+}
+
+auto SolveService::stats() const -> SolveStats {
+    auto stats = SolveStats{};
+    stats.uptimeMillis = micros(std::chrono::steady_clock::now() - m_start) / 1000;
+    stats.connections = m_connections;
+    stats.requests = m_requests;
+    stats.solved = m_solved;
+    stats.failed = m_failed;
+    stats.badRequests = m_badRequests;
+    stats.batches = m_batchCount;
+    stats.latencyMaxMicros = m_latencyMax;
+    stats.overloaded = m_overloaded;
+
+    std::array<std::uint64_t, latencyBucketCount> buckets;
+    std::uint64_t count = 0;
+    for (int i = 0; i < latencyBucketCount; ++i) {
+        buckets[i] = m_latencyBuckets[i];
+        count += buckets[i];
+    }
+    if (count == 0) return stats;
+
+    stats.latencyMeanMicros = m_latencyTotal / count;
+
+    // upper bound of the bucket the percentile falls into, bucket i holds bit_width(us) == i
+    auto percentile = [&](double p) {
+        auto rank = static_cast<std::uint64_t>(p * static_cast<double>(count - 1)) + 1;
+        std::uint64_t seen = 0;
+        for (int i = 0; i < latencyBucketCount; ++i) {
+            seen += buckets[i];
+            if (seen >= rank) return std::min((std::uint64_t(1) << i) - 1, stats.latencyMaxMicros);
+        }
+        return stats.latencyMaxMicros;
+    };
+    stats.latencyP50Micros = percentile(0.5);
+    stats.latencyP99Micros = percentile(0.99);
+
+    return stats;
+}
+
+auto SolveService::readConnection(std::shared_ptr<Connection> connection) -> void {
+    auto writer = std::thread(&SolveService::writeConnection, this, connection);
+
+    auto reply = [&connection](const SolveFrame& frame) {
+        std::vector<std::uint8_t> bytes;
+        appendFrame(bytes, frame);
+        connection->post(bytes, 0);
+    };
+
+    while (auto frame = receiveFrame(connection->fd)) {
+        if (frame->type == SolveMessage::STATS) {
+            reply(encodeStats(frame->id, stats()));
+            continue;
+        }
+
+        ++m_requests;
+
+        auto request = decodeRequest(*frame);
+        if (!request) {
+            ++m_badRequests;
+            reply(encodeResponse(SolveResponse{ .id = frame->id, .status = SolveStatus::BAD_REQUEST, .solveMicros = 0, .stages = {} }));
+            continue;
+        }
+
+        bool queued = false;
+        {
+            std::lock_guard lock{ m_queueMutex };
+            if (m_queued < m_config.maxQueued) {
+                {
+                    std::lock_guard outboxLock{ connection->outboxMutex };
+                    ++connection->unanswered;
+                }
+                m_pending.push_back(PendingRequest{ std::move(*request), connection, std::chrono::steady_clock::now() });
+                ++m_queued;
+                queued = true;
+            }
+        }
+
+        if (!queued) {
+            // answering right away lets a client back off instead of growing the queue without bound
+            ++m_overloaded;
+            reply(encodeResponse(SolveResponse{ .id = frame->id, .status = SolveStatus::REJECTED, .solveMicros = 0, .stages = {} }));
+            continue;
+        }
+        m_pendingCondition.notify_one();
+    }
+
+    // a client may half close after its last request and still wait for the solutions
+    {
+        std::lock_guard lock{ connection->outboxMutex };
+        connection->reading = false;
+        connection->outboxCondition.notify_one();
+    }
+    writer.join();
+
+    connection->open = false;
+}
+
+auto SolveService::writeConnection(std::shared_ptr<Connection> connection) -> void {
+    std::unique_lock lock{ connection->outboxMutex };
+
+    while (true) {
+        connection->outboxCondition.wait(lock, [&connection] {
+            return connection->dropped || !connection->outbox.empty() || (!connection->reading && connection->unanswered == 0);
+        });
+        if (connection->dropped || connection->outbox.empty()) return;
+
+        auto bytes = std::move(connection->outbox);
+        connection->outbox.clear();
+
+        lock.unlock();
+        bool sent = sendBytes(connection->fd, bytes);
+        lock.lock();
+
+        // a peer that stopped reading hits SO_SNDTIMEO here
+        if (!sent) {
+            connection->dropLocked();
+            return;
+        }
+    }
+}
+
+auto SolveService::dispatch() -> void {
+    std::unique_lock lock{ m_queueMutex };
+
+    while (true) {
+        m_pendingCondition.wait(lock, [this] { return m_stopping || !m_pending.empty(); });
+        if (m_pending.empty()) {
+            m_batchCondition.notify_all();
+            return;
+        }
+
+        // give concurrent requests a moment to join the batch
+        auto deadline = m_pending.front().received + m_config.batchDelay;
+        m_pendingCondition.wait_until(lock, deadline, [this] { return m_stopping || m_pending.size() >= m_config.maxBatch; });
+
+        auto count = std::min(m_pending.size(), std::max<std::size_t>(m_config.maxBatch, 1));
+
+        // one slice per worker, so a burst runs on the whole pool
+        auto slices = std::min<std::size_t>(count, m_workerCount);
+        for (std::size_t s = 0; s < slices; ++s) {
+            auto begin = m_pending.begin() + static_cast<std::ptrdiff_t>(count * s / slices);
+            auto end = m_pending.begin() + static_cast<std::ptrdiff_t>(count * (s + 1) / slices);
+            m_batches.emplace_back(std::make_move_iterator(begin), std::make_move_iterator(end));
+        }
+        m_pending.erase(m_pending.begin(), m_pending.begin() + static_cast<std::ptrdiff_t>(count));
+
+        ++m_batchCount;
+        m_batchCondition.notify_all();
+    }
+}
+
+auto SolveService::work() -> void {
+    PROFILE_THREAD_NAME("solve worker");
+
+    while (true) {
+        Batch batch;
+        {
+            std::unique_lock lock{ m_queueMutex };
+            m_batchCondition.wait(lock, [this] { return !m_batches.empty() || (m_stopping && m_pending.empty()); });
+            if (m_batches.empty()) return;
+
+            batch = std::move(m_batches.front());
+            m_batches.pop_front();
+            m_queued -= batch.size();
+        }
+
+        PROFILE_SCOPE("solve batch");
+        // all solutions for one connection go out in a single post
+        std::map<std::shared_ptr<Connection>, std::pair<std::vector<std::uint8_t>, std::size_t>> replies;
+        for (const auto& pending : batch) {
+            auto response = solve(pending.request);
+            if (response.status == SolveStatus::OK) ++m_solved;
+            else if (response.status == SolveStatus::BAD_REQUEST) ++m_badRequests;
+            else ++m_failed;
+
+            auto& [bytes, count] = replies[pending.connection];
+            appendFrame(bytes, encodeResponse(response));
+            ++count;
+        }
+
+        auto answered = std::chrono::steady_clock::now();
+        for (auto& [connection, reply] : replies) connection->post(reply.first, reply.second);
+
+        for (const auto& pending : batch) recordLatency(answered - pending.received);
+    }
+}
+
+auto SolveService::solve(const SolveRequest& request) -> SolveResponse {
+    auto response = SolveResponse{ .id = request.id, .status = SolveStatus::OK, .solveMicros = 0, .stages = {} };
+    auto start = std::chrono::steady_clock::now();
+
+    auto cube = solvedCubieCube();
+    if (request.state) {
+        cube = unpackState(*request.state);
+
+        // out of range coordinates wrap around when decoded and would not survive the round trip
+        if (packState(cube) != *request.state) {
+            response.status = SolveStatus::BAD_REQUEST;
+            return response;
+        }
+    }
+    else {
+        for (auto move : request.scramble) applyMove(cube, move);
+    }
+
+    if (!isSolvable(cube)) {
+        response.status = SolveStatus::FAILED;
+        return response;
+    }
+
+    try {
+        if (request.solver == SolverKind::CFOP) {
+            response.stages = m_cfop.solve(cube);
+        }
+        else {
+            // the bidirectional search is multithreaded and memory hungry by itself
+            std::lock_guard lock{ m_optimalMutex };
+            auto solver = BidirectionalSolver({ .maxDepth = m_config.optimalMaxDepth, .memoryLimit = m_config.optimalMemoryLimit, .threads = 0 });
+
+            if (auto moves = solver.solve(cube)) response.stages.push_back(SolveStage{ "optimal", *moves });
+            else response.status = SolveStatus::FAILED;
+        }
+    }
+    catch (const std::runtime_error&) {
+        response.status = SolveStatus::FAILED;
+    }
+
+    response.solveMicros = static_cast<std::uint32_t>(micros(std::chrono::steady_clock::now() - start));
+    return response;
+}
+
+auto SolveService::recordLatency(std::chrono::steady_clock::duration latency) -> void {
+    auto us = micros(latency);
+
+    m_latencyTotal += us;
+    auto max = m_latencyMax.load();
+    while (us > max && !m_latencyMax.compare_exchange_weak(max, us)) {}
+
+    auto bucket = std::min<int>(std::bit_width(us), latencyBucketCount - 1);
+    ++m_latencyBuckets[bucket];
+}
@@ -0,0 +1,275 @@
+#include "state_dataset.h"
+
+#include <bit>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+
+static_assert(std::endian::native == std::endian::little, "dataset files are little endian");
+static_assert(sizeof(PackedState) == 9 && alignof(PackedState) == 1);
+
+namespace {
+
+constexpr char datasetMagic[8] = { 'C', 'U', 'B', 'E', 'S', 'E', 'T', '\0' };
+constexpr std::uint32_t datasetVersion = 1;
+constexpr std::size_t segmentAlignment = 64;
+
+struct DatasetHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t columnCount;
+    std::uint64_t rowCount;
+    std::uint64_t rowsPerBlock;
+    std::uint64_t dataOffset;
+    std::uint8_t reserved[24];
+};
+
+struct DatasetColumn {
+    char name[24];
+    std::uint32_t elementSize;
+    std::uint32_t reserved;
+};
+
+static_assert(sizeof(DatasetHeader) == 64);
+static_assert(sizeof(DatasetColumn) == 32);
+
+auto align(std::size_t n) -> std::size_t {
+    return (n + segmentAlignment - 1) / segmentAlignment * segmentAlignment;
+}
+
+auto dataOffset(std::size_t columnCount) -> std::size_t {
+    return align(sizeof(DatasetHeader) + columnCount * sizeof(DatasetColumn));
+}
+
+auto blockSize(const std::vector<DatasetColumnSpec>& columns, std::size_t rows) -> std::size_t {
+    std::size_t size = 0;
+    for (const auto& c : columns) size += align(rows * c.elementSize);
+    return size;
+}
+
+} // namespace
+
+
+StateDatasetWriter::StateDatasetWriter(const std::filesystem::path& path, std::vector<DatasetColumnSpec> extraColumns, std::size_t rowsPerBlock) :
+    m_file{ path, std::ios::binary | std::ios::trunc },
+    m_columns{},
+    m_buffers{},
+    m_rowsPerBlock{ std::max<std::size_t>(rowsPerBlock, 1) },
+    m_rowsInBlock{ 0 },
+    m_rowCount{ 0 },
+    m_extraSize{ 0 }
+{
+    if (!m_file.is_open()) throw std::runtime_error("could not create dataset: " + path.string());
+
+    m_columns.push_back(DatasetColumnSpec{ "state", sizeof(PackedState) });
+    for (auto& c : extraColumns) {
+        if (c.name.size() >= sizeof(DatasetColumn::name) || c.elementSize == 0) throw std::runtime_error("invalid dataset column: " + c.name);
+        m_extraSize += c.elementSize;
+        m_columns.push_back(std::move(c));
+    }
+
+    for (const auto& c : m_columns) m_buffers.emplace_back().reserve(m_rowsPerBlock * c.elementSize);
+
+    // header is rewritten with the final row count in close()
+    auto header = DatasetHeader{};
+    std::memcpy(header.magic, datasetMagic, sizeof(datasetMagic));
+    header.version = datasetVersion;
+    header.columnCount = static_cast<std::uint32_t>(m_columns.size());
+    header.rowsPerBlock = m_rowsPerBlock;
+    header.dataOffset = dataOffset(m_columns.size());
+    m_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    for (const auto& c : m_columns) {
+        auto column = DatasetColumn{};
+        std::memcpy(column.name, c.name.data(), c.name.size());
+        column.elementSize = c.elementSize;
+        m_file.write(reinterpret_cast<const char*>(&column), sizeof(column));
+    }
+
+    auto padding = header.dataOffset - sizeof(header) - m_columns.size() * sizeof(DatasetColumn);
+    m_file.write(std::string(padding, '\0').data(), static_cast<std::streamsize>(padding));
+}
+
+StateDatasetWriter::~StateDatasetWriter() {
+    try {
+        close();
+    }
+    catch (...) {
+    }
+}
+
+auto StateDatasetWriter::append(const PackedState& state, std::span<const std::uint8_t> extra) -> void {
+    if (extra.size() != m_extraSize) throw std::runtime_error("dataset row has the wrong size!");
+
+    m_buffers[0].insert(m_buffers[0].end(), state.begin(), state.end());
+
+    auto data = extra.data();
+    for (std::size_t c = 1; c < m_columns.size(); ++c) {
+        m_buffers[c].insert(m_buffers[c].end(), data, data + m_columns[c].elementSize);
+        data += m_columns[c].elementSize;
+    }
+
+    ++m_rowCount;
+    if (++m_rowsInBlock == m_rowsPerBlock) flushBlock();
+}
+
+auto StateDatasetWriter::close() -> void {
+    if (!m_file.is_open()) return;
+
+    flushBlock();
+
+    m_file.seekp(offsetof(DatasetHeader, rowCount));
+    m_file.write(reinterpret_cast<const char*>(&m_rowCount), sizeof(m_rowCount));
+    m_file.close();
+
+    if (m_file.fail()) throw std::runtime_error("writing the dataset failed!");
+}
+
+auto StateDatasetWriter::flushBlock() -> void {
+    if (m_rowsInBlock == 0) return;
+
+    for (auto& buffer : m_buffers) {
+        buffer.resize(align(buffer.size()), 0);
+        m_file.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+        buffer.clear();
+    }
+
+    m_rowsInBlock = 0;
+}
+
+StateDataset::StateDataset(const std::filesystem::path& path) :
+    m_data{ nullptr },
+    m_size{ 0 },
+    m_mapping{ nullptr },
+    m_columns{},
+    m_rowCount{ 0 },
+    m_rowsPerBlock{ 1 },
+    m_dataOffset{ 0 },
+    m_fullBlockSize{ 0 }
+{
+#ifdef _WIN32
+    auto file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) throw std::runtime_error("could not open dataset: " + path.string());
+
+    LARGE_INTEGER size;
+    GetFileSizeEx(file, &size);
+    m_size = static_cast<std::size_t>(size.QuadPart);
+
+    m_mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (!m_mapping) throw std::runtime_error("could not map dataset: " + path.string());
+
+    m_data = static_cast<const std::uint8_t*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw std::runtime_error("could not open dataset: " + path.string());
+
+    struct stat info;
+    fstat(fd, &info);
+    m_size = static_cast<std::size_t>(info.st_size);
+
+    auto data = (m_size > 0) ? mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+    close(fd);
+    if (data != MAP_FAILED) {
+        m_data = static_cast<const std::uint8_t*>(data);
+        // mostly streamed front to back
+        madvise(data, m_size, MADV_SEQUENTIAL);
+    }
+#endif
+
+    if (!m_data || m_size < sizeof(DatasetHeader)) {
+        unmap();
+        throw std::runtime_error("could not map dataset: " + path.string());
+    }
+
+    DatasetHeader header;
+    std::memcpy(&header, m_data, sizeof(header));
+
+    auto valid = std::memcmp(header.magic, datasetMagic, sizeof(datasetMagic)) == 0
+        && header.version == datasetVersion
+        && header.columnCount >= 1
+        && header.rowsPerBlock >= 1
+        && header.dataOffset == dataOffset(header.columnCount)
+        && header.dataOffset <= m_size;
+
+    if (valid) {
+        for (std::uint32_t c = 0; c < header.columnCount; ++c) {
+            DatasetColumn column;
+            std::memcpy(&column, m_data + sizeof(header) + c * sizeof(column), sizeof(column));
+            column.name[sizeof(column.name) - 1] = '\0';
+            m_columns.push_back(DatasetColumnSpec{ column.name, column.elementSize });
+        }
+
+        m_rowCount = header.rowCount;
+        m_rowsPerBlock = header.rowsPerBlock;
+        m_dataOffset = header.dataOffset;
+        m_fullBlockSize = blockSize(m_columns, m_rowsPerBlock);
+
+        valid = m_columns[0].name == "state" && m_columns[0].elementSize == sizeof(PackedState)
+            && (m_rowCount == 0 || blockOffset(blockCount() - 1) + blockSize(m_columns, m_rowCount - (blockCount() - 1) * m_rowsPerBlock) <= m_size);
+    }
+
+    if (!valid) {
+        unmap();
+        throw std::runtime_error("not a valid dataset: " + path.string());
+    }
+}
+
+StateDataset::~StateDataset() {
+    unmap();
+}
+
+auto StateDataset::columnIndex(const std::string& name) const -> int {
+    for (std::size_t c = 0; c < m_columns.size(); ++c) {
+        if (m_columns[c].name == name) return static_cast<int>(c);
+    }
+    return -1;
+}
+
+auto StateDataset::columnBytes(std::uint64_t block, int column) const -> std::span<const std::uint8_t> {
+    if (block >= blockCount() || column < 0 || column >= static_cast<int>(m_columns.size())) {
+        throw std::runtime_error("dataset block or column out of range!");
+    }
+
+    auto rows = std::min(m_rowsPerBlock, m_rowCount - block * m_rowsPerBlock);
+
+    auto offset = blockOffset(block);
+    for (int c = 0; c < column; ++c) offset += align(rows * m_columns[c].elementSize);
+
+    return { m_data + offset, rows * m_columns[column].elementSize };
+}
+
+auto StateDataset::state(std::uint64_t row) const -> const PackedState& {
+    if (row >= m_rowCount) throw std::runtime_error("dataset row out of range!");
+    return states(row / m_rowsPerBlock)[row % m_rowsPerBlock];
+}
+
+auto StateDataset::blockOffset(std::uint64_t block) const -> std::size_t {
+    return m_dataOffset + block * m_fullBlockSize;
+}
+
+auto StateDataset::unmap() -> void {
+#ifdef _WIN32
+    if (m_data) UnmapViewOfFile(m_data);
+    if (m_mapping) CloseHandle(m_mapping);
+    m_mapping = nullptr;
+#else
+    if (m_data) munmap(const_cast<std::uint8_t*>(m_data), m_size);
+#endif
+    m_data = nullptr;
+}
+
+auto StateDataset::checkElementSize(int column, std::size_t size) const -> void {
+    if (m_columns[column].elementSize != size) throw std::runtime_error("dataset column " + m_columns[column].name + " has a different element size!");
+}
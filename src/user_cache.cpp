@@ -0,0 +1,68 @@
+#include "user_cache.h"
+
+#include <cstdlib>
+#include <system_error>
+
+#ifndef _WIN32
+#include <pwd.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#endif
+
+
+namespace {
+
+auto cacheRoot() -> std::filesystem::path {
+#ifdef _WIN32
+    if (auto local = std::getenv("LOCALAPPDATA"); local && *local) return local;
+    return {};
+#else
+    // relative paths are invalid in XDG_CACHE_HOME and are ignored
+    if (auto xdg = std::getenv("XDG_CACHE_HOME"); xdg && xdg[0] == '/') return xdg;
+    if (auto home = std::getenv("HOME"); home && home[0] == '/') return std::filesystem::path(home) / ".cache";
+    if (auto user = ::getpwuid(::geteuid()); user && user->pw_dir) return std::filesystem::path(user->pw_dir) / ".cache";
+    return {};
+#endif
+}
+
+auto runtimeRoot() -> std::filesystem::path {
+#ifndef _WIN32
+    if (auto xdg = std::getenv("XDG_RUNTIME_DIR"); xdg && xdg[0] == '/') return xdg;
+#endif
+    return cacheRoot();
+}
+
+auto privateDirectory(const std::filesystem::path& root, const std::string& name) -> std::filesystem::path {
+    if (root.empty()) return {};
+
+    std::error_code error;
+    std::filesystem::create_directories(root, error);
+    if (error) return {};
+
+    auto directory = root / name;
+
+#ifdef _WIN32
+    std::filesystem::create_directory(directory, error);
+    if (error) return {};
+#else
+    // fails if anything is at the path already, lstat decides whether it can be used
+    ::mkdir(directory.c_str(), 0700);
+
+    struct stat info{};
+    if (::lstat(directory.c_str(), &info) != 0) return {};
+    if (!S_ISDIR(info.st_mode) || info.st_uid != ::geteuid() || (info.st_mode & (S_IWGRP | S_IWOTH)) != 0) return {};
+#endif
+
+    return directory;
+}
+
+} // namespace
+
+
+auto userCacheDirectory(const std::string& name) -> std::filesystem::path {
+    return privateDirectory(cacheRoot(), name);
+}
+
+auto userRuntimeDirectory(const std::string& name) -> std::filesystem::path {
+    return privateDirectory(runtimeRoot(), name);
+}
@@ -0,0 +1,110 @@
+#include <iostream>
+#include <random>
+#include <string>
+#include <stdexcept>
+#include <utility>
+
+#include "cubie_cube.h"
+#include "bidirectional_solver.h"
+
+
+namespace {
+
+int failures = 0;
+
+auto check(bool ok, const std::string& what) -> void {
+    std::cout << (ok ? "ok     " : "FAILED ") << what << "\n";
+    if (!ok) ++failures;
+}
+
+auto throwsOnRead(const CubeState& state) -> bool {
+    try {
+        cubieFromState(state);
+    }
+    catch (const std::runtime_error&) {
+        return true;
+    }
+    return false;
+}
+
+// A cube that is rejected by isSolvable, by the sticker reader and by the solvers
+auto checkInvalid(const CubieCube& cube, const std::string& what, bool readable) -> void {
+    check(!isSolvable(cube), what + ": not solvable");
+
+    auto state = stateFromCubie(cube);
+    if (readable) check(!isSolvable(cubieFromState(state)), what + ": stickers read back as not solvable");
+    else check(throwsOnRead(state), what + ": reading the stickers throws");
+
+    auto solver = BidirectionalSolver({ .maxDepth = 4, .memoryLimit = std::size_t(1) << 24, .threads = 1 });
+    check(!solver.solve(cube), what + ": no solution");
+}
+
+} // namespace
+
+
+// Usage: check_cube_states [--count N] [--seed S]
+// Checks that the facelet and cubie views of the cube agree on random scrambles and that
+// twisted, flipped, swapped and duplicated pieces are rejected, exits with 1 on any failure.
+auto main(int argc, char** argv) -> int {
+    std::size_t count = 10000;
+    std::uint64_t seed = 1;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        std::string value = argv[i + 1];
+
+        if (arg == "--count") count = std::stoull(value);
+        else if (arg == "--seed") seed = std::stoull(value);
+        else {
+            std::cout << "unknown argument: " << arg << "\n";
+            return -1;
+        }
+    }
+
+    std::mt19937_64 rng{ seed };
+    bool roundTrips = true;
+    for (std::size_t i = 0; i < count && roundTrips; ++i) {
+        auto state = solvedCubeState();
+        auto cube = solvedCubieCube();
+        for (int m = 0; m < 40; ++m) {
+            auto move = static_cast<Move>(rng() % moveCount);
+            applyMove(state, move);
+            applyMove(cube, move);
+        }
+        roundTrips = cubieFromState(state) == cube && stateFromCubie(cube) == state && isSolvable(cube);
+    }
+    check(roundTrips, std::to_string(count) + " scrambles: facelet and cubie views agree and are solvable");
+
+    auto twisted = solvedCubieCube();
+    twisted.cornerOrient[0] = 1;
+    checkInvalid(twisted, "twisted corner", true);
+
+    auto flipped = solvedCubieCube();
+    flipped.edgeOrient[0] = 1;
+    checkInvalid(flipped, "flipped edge", true);
+
+    auto swapped = solvedCubieCube();
+    std::swap(swapped.edgePerm[0], swapped.edgePerm[1]);
+    checkInvalid(swapped, "swapped edges", true);
+
+    auto cornerTwice = solvedCubieCube();
+    cornerTwice.cornerPerm[1] = 0;
+    checkInvalid(cornerTwice, "corner 0 twice, corner 1 missing", false);
+
+    auto edgeTwice = solvedCubieCube();
+    edgeTwice.edgePerm[5] = 4;
+    checkInvalid(edgeTwice, "edge 4 twice, edge 5 missing", false);
+
+    // both duplicated, the parities still match
+    auto bothTwice = solvedCubieCube();
+    bothTwice.cornerPerm[1] = 0;
+    bothTwice.edgePerm[5] = 4;
+    checkInvalid(bothTwice, "corner and edge twice", false);
+
+    auto outOfRange = solvedCubieCube();
+    outOfRange.cornerOrient[0] = 3;
+    check(!isSolvable(outOfRange), "corner twist 3: not solvable");
+
+    std::cout << (failures == 0 ? "all checks passed\n" : std::to_string(failures) + " checks failed\n");
+    return failures == 0 ? 0 : 1;
+}
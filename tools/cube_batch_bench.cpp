@@ -0,0 +1,112 @@
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include "rubiks_cube.h"
+#include "cube_batch.h"
+
+
+namespace {
+
+template <typename F>
+auto measure(F&& f) -> double {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+auto report(const std::string& name, double seconds, double moves) -> void {
+    std::cout << name << ": " << seconds << " s, " << moves / seconds / 1e6 << " M cube moves/s\n";
+}
+
+} // namespace
+
+
+// Usage: cube_batch_bench [--cubes N] [--moves M] [--seed X]
+// Applies the same random move sequence to N cubes, once per cube object and once as a batch.
+auto main(int argc, char** argv) -> int {
+    std::size_t cubeCount = 100000;
+    std::size_t moveCount = 200;
+    std::uint64_t seed = 1;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        std::string value = argv[i + 1];
+
+        if (arg == "--cubes") cubeCount = std::stoull(value);
+        else if (arg == "--moves") moveCount = std::stoull(value);
+        else if (arg == "--seed") seed = std::stoull(value);
+        else {
+            std::cout << "unknown argument: " << arg << "\n";
+            return -1;
+        }
+    }
+
+    std::mt19937_64 rng{ seed };
+    std::vector<Move> moves(moveCount);
+    for (auto& move : moves) move = static_cast<Move>(rng() % ::moveCount);
+
+    // every cube starts from its own short scramble so the batch is not uniform
+    std::vector<CubieCube> start(cubeCount, solvedCubieCube());
+    for (auto& cube : start) {
+        for (int i = 0; i < 20; ++i) applyMove(cube, static_cast<Move>(rng() % ::moveCount));
+    }
+
+    auto total = static_cast<double>(cubeCount) * static_cast<double>(moveCount);
+    std::cout << cubeCount << " cubes, " << moveCount << " moves, " << (CubeBatch::vectorized() ? "AVX2" : "scalar") << " batch kernel\n";
+
+    // RubiksCube: queue the turn and finish it with one long update, as the renderer would
+    {
+        auto objectCount = std::min<std::size_t>(cubeCount, 10000);
+        std::vector<RubiksCube> cubes(objectCount, RubiksCube(400.0f, 1.0f, 0));
+        for (auto& cube : cubes) cube.init();
+
+        auto seconds = measure([&] {
+            for (auto& cube : cubes) {
+                for (auto move : moves) {
+                    cube.addMove(RubiksCube::toRotationConfig(move));
+                    cube.update(1.0f);
+                }
+            }
+        });
+        report("RubiksCube (" + std::to_string(objectCount) + " objects)", seconds, static_cast<double>(objectCount) * static_cast<double>(moveCount));
+    }
+
+    auto facelets = std::vector<CubeState>{};
+    for (const auto& cube : start) facelets.push_back(stateFromCubie(cube));
+    report("CubeState loop", measure([&] {
+        for (auto& state : facelets) {
+            for (auto move : moves) applyMove(state, move);
+        }
+    }), total);
+
+    auto cubies = start;
+    report("CubieCube loop", measure([&] {
+        for (auto& cube : cubies) {
+            for (auto move : moves) applyMove(cube, move);
+        }
+    }), total);
+
+    auto batch = CubeBatch(cubeCount);
+    for (std::size_t i = 0; i < cubeCount; ++i) batch.set(i, start[i]);
+    report("CubeBatch::applyMove", measure([&] {
+        for (auto move : moves) batch.applyMove(move);
+    }), total);
+
+    auto sliced = CubeBatch(cubeCount);
+    for (std::size_t i = 0; i < cubeCount; ++i) sliced.set(i, start[i]);
+    report("CubeBatch::applyMoves", measure([&] {
+        sliced.applyMoves(moves);
+    }), total);
+
+    for (std::size_t i = 0; i < cubeCount; ++i) {
+        if (batch.get(i) != cubies[i] || sliced.get(i) != cubies[i]) {
+            std::cout << "batch result differs from CubieCube for cube " << i << "\n";
+            return -1;
+        }
+    }
+
+    return 0;
+}
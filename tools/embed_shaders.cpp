@@ -0,0 +1,77 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <cctype>
+#include <filesystem>
+
+
+namespace {
+
+// shader/rubiks_cube.vert -> rubiksCubeVert
+auto variableName(const std::filesystem::path& path) -> std::string {
+    std::string name;
+    bool upper = false;
+
+    for (auto c : path.filename().string()) {
+        if (c == '_' || c == '.' || c == '-') {
+            upper = true;
+            continue;
+        }
+        name += upper ? static_cast<char>(std::toupper(static_cast<unsigned char>(c))) : c;
+        upper = false;
+    }
+    return name;
+}
+
+} // namespace
+
+
+// Usage: embed_shaders OUTPUT_HEADER SHADER...
+// Build step that turns the GLSL files into string constants, e.g.
+//   embed_shaders include/embedded_shaders.h shader/rubiks_cube.vert shader/rubiks_cube.frag
+auto main(int argc, char** argv) -> int {
+    if (argc < 3) {
+        std::cout << "usage: embed_shaders OUTPUT_HEADER SHADER...\n";
+        return -1;
+    }
+
+    std::ostringstream out;
+    out << "#pragma once\n\n";
+    out << "// Generated by tools/embed_shaders.cpp from the files in shader/, do not edit.\n\n";
+    out << "#include <string_view>\n\n\n";
+
+    for (int i = 2; i < argc; ++i) {
+        std::filesystem::path path = argv[i];
+
+        std::ifstream file{ path };
+        if (!file.is_open()) {
+            std::cout << "failed to open " << path.string() << "\n";
+            return -1;
+        }
+
+        std::ostringstream source;
+        source << file.rdbuf();
+
+        if (source.str().find(")glsl\"") != std::string::npos) {
+            std::cout << path.string() << " contains the raw string delimiter\n";
+            return -1;
+        }
+
+        out << "// " << path.filename().string() << "\n";
+        out << "constexpr std::string_view " << variableName(path) << " = R\"glsl(" << source.str() << ")glsl\";\n\n";
+    }
+
+    // only touch the header if something changed, so the build does not recompile needlessly
+    auto header = out.str();
+    std::ifstream existing{ argv[1] };
+    if (existing.is_open()) {
+        std::ostringstream current;
+        current << existing.rdbuf();
+        if (current.str() == header) return 0;
+    }
+
+    std::ofstream file{ argv[1], std::ios::trunc };
+    file << header;
+    return file ? 0 : -1;
+}
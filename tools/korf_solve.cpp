@@ -0,0 +1,81 @@
+#include <iostream>
+#include <string>
+#include <random>
+#include <chrono>
+
+#include "korf_solver.h"
+#include "user_cache.h"
+
+
+// Usage: korf_solve [--threads T] [--databases DIR] [--max-depth N] [--interval MS] [--random N] [--seed X] [MOVES]
+// Solves the scramble MOVES (e.g. "R U R' F2") or N random quarter turns optimally.
+auto main(int argc, char** argv) -> int {
+    auto config = KorfSolverConfig{};
+    int randomMoves = 0;
+    std::uint64_t seed = 1;
+    std::string notation;
+
+    // empty without a private cache directory, the databases are then generated every run
+    config.databaseDirectory = userCacheDirectory("cube_pattern_databases");
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--", 0) != 0) {
+            notation = arg;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            std::cout << "missing value for " << arg << "\n";
+            return -1;
+        }
+
+        std::string value = argv[++i];
+        if (arg == "--threads") config.threads = static_cast<unsigned int>(std::stoul(value));
+        else if (arg == "--databases") config.databaseDirectory = value;
+        else if (arg == "--max-depth") config.maxDepth = std::stoi(value);
+        else if (arg == "--interval") config.progressInterval = std::chrono::milliseconds(std::stoll(value));
+        else if (arg == "--random") randomMoves = std::stoi(value);
+        else if (arg == "--seed") seed = std::stoull(value);
+        else {
+            std::cout << "unknown argument: " << arg << "\n";
+            return -1;
+        }
+    }
+
+    std::vector<Move> scramble;
+    if (randomMoves > 0) {
+        std::mt19937_64 rng(seed);
+        std::uniform_int_distribution<int> move(0, moveCount - 1);
+        for (int i = 0; i < randomMoves; ++i) scramble.push_back(static_cast<Move>(move(rng)));
+    }
+    else {
+        scramble = movesFromString(notation);
+    }
+
+    auto cube = solvedCubieCube();
+    for (auto move : scramble) applyMove(cube, move);
+    std::cout << "scramble: " << movesToString(scramble) << "\n";
+
+    auto setupStart = std::chrono::steady_clock::now();
+    auto solver = KorfSolver(config);
+    auto setupSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - setupStart).count();
+    std::cout << "pattern databases: " << (solver.generatedDatabases() > 0 ? "generated" : "loaded")
+              << " in " << setupSeconds << " s\n";
+
+    solver.setProgressCallback([](const KorfSolverStats& stats) {
+        std::cout << "bound " << stats.bound << ": " << stats.nodes << " nodes, " << stats.seconds << " s, "
+                  << stats.nodesPerSecond() / 1e6 << "M nodes/s\n";
+    });
+
+    auto solution = solver.solve(cube);
+    if (!solution) {
+        std::cout << "no solution within " << config.maxDepth << " quarter turns\n";
+        return 1;
+    }
+
+    const auto& stats = solver.stats();
+    std::cout << "solution (" << solution->size() << " quarter turns): " << movesToString(*solution) << "\n";
+    std::cout << stats.nodes << " nodes in " << stats.seconds << " s, " << stats.nodesPerSecond() / 1e6 << "M nodes/s\n";
+
+    return 0;
+}
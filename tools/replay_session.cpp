@@ -0,0 +1,94 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "session_replay.h"
+
+
+namespace {
+
+auto printReport(const std::string& name, const ReplayReport& report) -> void {
+    std::cout << name << ": " << report.frames << " frames, " << report.turns << " turns, "
+              << report.checkpoints << " checkpoints, max drift " << report.maxDrift << "\n";
+    std::cout << "  " << report.simulatedSeconds << " s simulated in " << report.seconds << " s ("
+              << report.speedup() << "x real time): " << (report.passed() ? "passed" : "FAILED") << "\n";
+
+    for (const auto& failure : report.failures) {
+        std::cout << "  " << replayFailureName(failure.kind) << " at event " << failure.event << ", frame " << failure.frame;
+        if (failure.facelets > 0) std::cout << ": " << failure.facelets << " facelets differ";
+        if (failure.drift > 0.0f) std::cout << ": drift " << failure.drift;
+        std::cout << "\n";
+    }
+    if (report.failureCount > report.failures.size()) {
+        std::cout << "  ... " << report.failureCount - report.failures.size() << " more failures\n";
+    }
+}
+
+} // namespace
+
+
+// Usage: replay_session [--tolerance X] [--random TURNS] [--seed S] [--write FILE] [TRACE...]
+// Replays recorded session traces (T in the viewer records one) and/or a generated one
+// headlessly, exits with 1 if any checkpoint failed.
+auto main(int argc, char** argv) -> int {
+    auto config = ReplayConfig{};
+    std::size_t randomTurns = 0;
+    std::uint64_t seed = 1;
+    std::string writePath;
+    std::vector<std::string> paths;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--", 0) != 0) {
+            paths.push_back(arg);
+            continue;
+        }
+        if (i + 1 >= argc) {
+            std::cout << "missing value for " << arg << "\n";
+            return -1;
+        }
+
+        std::string value = argv[++i];
+        if (arg == "--tolerance") config.driftTolerance = std::stof(value);
+        else if (arg == "--random") randomTurns = std::stoull(value);
+        else if (arg == "--seed") seed = std::stoull(value);
+        else if (arg == "--write") writePath = value;
+        else {
+            std::cout << "unknown argument: " << arg << "\n";
+            return -1;
+        }
+    }
+
+    if (paths.empty() && randomTurns == 0) {
+        std::cout << "nothing to replay, pass trace files or --random TURNS\n";
+        return -1;
+    }
+
+    bool passed = true;
+
+    if (randomTurns > 0) {
+        auto trace = randomSessionTrace(randomTurns, seed);
+        if (!writePath.empty() && !trace.save(writePath)) {
+            std::cout << "could not write " << writePath << "\n";
+            return -1;
+        }
+
+        auto report = replaySession(trace, config);
+        printReport("random (seed " + std::to_string(seed) + ")", report);
+        passed = passed && report.passed();
+    }
+
+    for (const auto& path : paths) {
+        try {
+            auto report = replaySession(SessionTrace::load(path), config);
+            printReport(path, report);
+            passed = passed && report.passed();
+        }
+        catch (const std::exception& e) {
+            std::cout << e.what() << "\n";
+            passed = false;
+        }
+    }
+
+    return passed ? 0 : 1;
+}
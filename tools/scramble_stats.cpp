@@ -0,0 +1,48 @@
+#include <iostream>
+#include <string>
+#include <chrono>
+
+#include "scramble_stats.h"
+
+
+// Usage: scramble_stats [--count N] [--threads T] [--steps S] [--seed X] [--generator shuffle|norepeat]
+auto main(int argc, char** argv) -> int {
+    auto config = ScrambleStatsConfig{};
+    int steps = 50;
+    std::string generatorName = "shuffle";
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        std::string value = argv[i + 1];
+
+        if (arg == "--count") config.scrambles = std::stoull(value);
+        else if (arg == "--threads") config.threads = static_cast<unsigned int>(std::stoul(value));
+        else if (arg == "--steps") steps = std::stoi(value);
+        else if (arg == "--seed") config.seed = std::stoull(value);
+        else if (arg == "--generator") generatorName = value;
+        else {
+            std::cout << "unknown argument: " << arg << "\n";
+            return -1;
+        }
+    }
+
+    ScrambleGenerator generator;
+    if (generatorName == "shuffle") generator = shuffleGenerator(steps);
+    else if (generatorName == "norepeat") generator = noRepeatGenerator(steps);
+    else {
+        std::cout << "unknown generator: " << generatorName << "\n";
+        return -1;
+    }
+
+    auto stats = ScrambleStats(generator, config);
+
+    auto start = std::chrono::steady_clock::now();
+    stats.run();
+    auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "generator: " << generatorName << ", " << steps << " steps\n";
+    stats.report(std::cout);
+    std::cout << "\n" << seconds << " s, " << static_cast<double>(config.scrambles) / seconds << " scrambles/s\n";
+
+    return 0;
+}
@@ -0,0 +1,119 @@
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <random>
+
+#include "solve_protocol.h"
+
+
+namespace {
+
+// pipelined requests without a solution yet, small enough that the unread replies fit
+// into the socket buffer even when every one of them is a separate send
+constexpr std::size_t maxInFlight = 128;
+
+auto printStats(const SolveStats& stats) -> void {
+    auto seconds = static_cast<double>(stats.uptimeMillis) / 1000.0;
+
+    std::cout << "uptime:      " << seconds << " s\n";
+    std::cout << "connections: " << stats.connections << "\n";
+    std::cout << "requests:    " << stats.requests << " (" << stats.solved << " solved, " << stats.failed << " failed, " << stats.badRequests << " bad, " << stats.overloaded << " rejected as overloaded)\n";
+    std::cout << "batches:     " << stats.batches;
+    if (stats.batches > 0) std::cout << " (" << static_cast<double>(stats.solved + stats.failed) / static_cast<double>(stats.batches) << " requests each)";
+    std::cout << "\n";
+    std::cout << "throughput:  " << (seconds > 0.0 ? static_cast<double>(stats.solved) / seconds : 0.0) << " solves/s over the uptime\n";
+    std::cout << "latency us:  mean " << stats.latencyMeanMicros << ", p50 " << stats.latencyP50Micros
+        << ", p99 " << stats.latencyP99Micros << ", max " << stats.latencyMaxMicros << "\n";
+}
+
+} // namespace
+
+
+// Usage: solve_client [--socket PATH] [--solver cfop|optimal] (--scramble "R U R' ..." | --random N [--length L] | --stats)
+// --random pipelines N random scrambles of L quarter turns, up to 128 in flight, and reports the round trip throughput.
+auto main(int argc, char** argv) -> int {
+    std::string socketPath = defaultSolveSocket();
+    std::string scramble;
+    std::size_t randomCount = 0;
+    int length = 25;
+    auto solver = SolverKind::CFOP;
+    bool stats = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--stats") {
+            stats = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            std::cout << "missing value for " << arg << "\n";
+            return -1;
+        }
+
+        std::string value = argv[++i];
+        if (arg == "--socket") socketPath = value;
+        else if (arg == "--scramble") scramble = value;
+        else if (arg == "--random") randomCount = std::stoull(value);
+        else if (arg == "--length") length = std::stoi(value);
+        else if (arg == "--solver") solver = (value == "optimal") ? SolverKind::OPTIMAL : SolverKind::CFOP;
+        else {
+            std::cout << "unknown argument: " << arg << "\n";
+            return -1;
+        }
+    }
+
+    try {
+        SolveClient client(socketPath);
+
+        if (!scramble.empty()) {
+            auto response = client.solve(movesFromString(scramble), solver);
+            if (response.status != SolveStatus::OK) {
+                std::cout << (response.status == SolveStatus::REJECTED ? "solve daemon is overloaded\n" : "no solution\n");
+                return -1;
+            }
+
+            for (const auto& stage : response.stages) std::cout << stage.label << ": " << movesToString(stage.moves) << "\n";
+            std::cout << "solved in " << response.solveMicros << " us\n";
+        }
+
+        if (randomCount > 0) {
+            std::mt19937_64 rng{ std::random_device{}() };
+            auto start = std::chrono::steady_clock::now();
+
+            std::size_t failed = 0;
+            std::size_t overloaded = 0;
+            auto receive = [&]() {
+                auto status = client.receive().status;
+                if (status == SolveStatus::REJECTED) ++overloaded;
+                else if (status != SolveStatus::OK) ++failed;
+            };
+
+            // the daemon answers a full queue right away, so solutions have to be read while
+            // submitting or both sides end up blocked on full socket buffers
+            std::size_t received = 0;
+            for (std::size_t i = 0; i < randomCount; ++i) {
+                if (i - received == maxInFlight) {
+                    receive();
+                    ++received;
+                }
+
+                std::vector<Move> moves(static_cast<std::size_t>(length));
+                for (auto& move : moves) move = static_cast<Move>(rng() % moveCount);
+                client.submit(moves, solver);
+            }
+            for (; received < randomCount; ++received) receive();
+
+            auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            std::cout << randomCount << " solves (" << failed << " failed, " << overloaded << " rejected by a full queue) in " << seconds << " s, "
+                << static_cast<double>(randomCount - overloaded) / seconds << " solves/s\n";
+        }
+
+        if (stats) printStats(client.stats());
+    }
+    catch (const std::runtime_error& e) {
+        std::cout << e.what() << "\n";
+        return -1;
+    }
+
+    return 0;
+}
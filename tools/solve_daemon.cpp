@@ -0,0 +1,67 @@
+#include <iostream>
+#include <string>
+#include <atomic>
+#include <csignal>
+#include <chrono>
+
+#include "solve_service.h"
+
+
+namespace {
+
+std::atomic<bool> stopRequested = false;
+
+auto onSignal(int) -> void {
+    stopRequested = true;
+}
+
+} // namespace
+
+
+// Usage: solve_daemon [--socket PATH] [--workers N] [--batch N] [--batch-delay US]
+//                     [--max-queued N] [--max-outbox KB] [--send-timeout MS]
+//                     [--optimal-depth D] [--optimal-memory MB]
+// Runs until SIGINT or SIGTERM, query it with solve_client --stats.
+auto main(int argc, char** argv) -> int {
+    auto config = SolveServiceConfig{};
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        std::string value = argv[i + 1];
+
+        if (arg == "--socket") config.socketPath = value;
+        else if (arg == "--workers") config.workers = static_cast<unsigned int>(std::stoul(value));
+        else if (arg == "--batch") config.maxBatch = std::stoull(value);
+        else if (arg == "--batch-delay") config.batchDelay = std::chrono::microseconds(std::stoll(value));
+        else if (arg == "--max-queued") config.maxQueued = std::stoull(value);
+        else if (arg == "--max-outbox") config.maxOutbox = std::stoull(value) << 10;
+        else if (arg == "--send-timeout") config.sendTimeout = std::chrono::milliseconds(std::stoll(value));
+        else if (arg == "--optimal-depth") config.optimalMaxDepth = std::stoi(value);
+        else if (arg == "--optimal-memory") config.optimalMemoryLimit = std::stoull(value) << 20;
+        else {
+            std::cout << "unknown argument: " << arg << "\n";
+            return -1;
+        }
+    }
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+
+    try {
+        auto start = std::chrono::steady_clock::now();
+        SolveService service(config);
+        auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout << "solver tables ready after " << seconds << " s, listening on " << config.socketPath << "\n";
+        service.run(stopRequested);
+
+        auto stats = service.stats();
+        std::cout << "served " << stats.requests << " requests on " << stats.connections << " connections\n";
+    }
+    catch (const std::runtime_error& e) {
+        std::cout << e.what() << "\n";
+        return -1;
+    }
+
+    return 0;
+}